@@ -12,6 +12,7 @@
 #include "random.h"
 #include "scene.h"
 #include "sdl_wrapper.h"
+#include "texture_cache.h"
 #include "vector.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -38,6 +39,7 @@ void check_player_boundaries(state_t *state) {
 game_t *emscripten_init() {
   init_rand();
   sdl_init(VEC_ZERO, PLAYSCREEN);
+  texture_cache_pack(ATLAS_FILES, ATLAS_FILE_COUNT);
 
   game_t *game = game_init();
   main_menu_init(game);
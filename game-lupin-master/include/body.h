@@ -1,11 +1,15 @@
 #ifndef __BODY_H__
 #define __BODY_H__
 
+#include "collision.h"
 #include "color.h"
 #include "list.h"
+#include "polygon.h"
+#include "prototype.h"
 #include "sprite.h"
 #include "vector.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * A rigid body constrained to the plane.
@@ -15,6 +19,31 @@
  */
 typedef struct body body_t;
 
+/**
+ * Contiguous storage for the state the physics loops touch every tick
+ * (position, velocity, forces, mass, orientation and shape) of a set of
+ * bodies. A body_t is a handle to its slot: the slot may move as the pool
+ * grows or is sorted, but the body_t pointer stays valid, so forces,
+ * contacts and game code keep holding bodies by pointer.
+ * A scene keeps its bodies in a pool (see scene_reorder_bodies()).
+ */
+typedef struct body_pool body_pool_t;
+
+/**
+ * Allocates memory for a body that shares a prototype's geometry.
+ * The body starts at rest with its centroid at the origin and angle 0;
+ * use body_set_centroid() to place it.
+ * Many bodies can reference one prototype, so e.g. every pellet of the same
+ * size shares a single vertex array.
+ *
+ * @param proto the body's shape in local space.
+ *   The body takes ownership of this reference and releases it when freed.
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param color the color of the body, used to draw it on the screen
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_prototype(prototype_t *proto, double mass, rgb_color_t color);
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_shape_with_info() where info and info_freer are NULL.
@@ -86,6 +115,33 @@ void body_free(body_t *body);
  */
 list_t *body_get_shape(body_t *body);
 
+/**
+ * Gets the prototype a body's shape is instanced from.
+ * The body keeps its reference; use prototype_retain() to keep it longer.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the body's shape in local space
+ */
+prototype_t *body_get_prototype(body_t *body);
+
+/**
+ * Gets the number of vertices in a body's shape.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the number of vertices
+ */
+size_t body_get_vertex_count(body_t *body);
+
+/**
+ * Gets one vertex of a body's current shape without allocating.
+ * Equivalent to list_get(body_get_shape(body), index).
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @param index the index of the vertex (starting at 0)
+ * @return the vertex in scene coordinates
+ */
+vector_t body_get_vertex(body_t *body, size_t index);
+
 /**
  * Gets the current center of mass of a body.
  * While this could be calculated with polygon_centroid(), that becomes too slow
@@ -97,6 +153,34 @@ list_t *body_get_shape(body_t *body);
  */
 vector_t body_get_centroid(body_t *body);
 
+/**
+ * Gets the area of a body's shape.
+ * Computed once when the body is created; rigid motion does not change it.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the area enclosed by the body's polygon
+ */
+double body_get_area(body_t *body);
+
+/**
+ * Gets the bounding radius of a body,
+ * i.e. the distance from its centroid to its farthest vertex.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the radius of the smallest centroid-centered circle around the body
+ */
+double body_get_radius(body_t *body);
+
+/**
+ * Gets the current axis-aligned bounding box of a body.
+ * The box is kept up to date as the body moves and rotates,
+ * so this is cheap to call every tick.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the smallest axis-aligned box containing the body
+ */
+aabb_t body_get_bounds(body_t *body);
+
 /**
  * Gets the current velocity of a body.
  *
@@ -113,6 +197,16 @@ vector_t body_get_velocity(body_t *body);
  */
 double body_get_mass(body_t *body);
 
+/**
+ * Gets the inverse of a body's mass, which is 0 for bodies of mass INFINITY.
+ * Impulse solvers work with inverse masses so immovable bodies need no
+ * special cases.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return 1 / mass, or 0 if the mass is INFINITY
+ */
+double body_get_inverse_mass(body_t *body);
+
 /**
  * Gets the display color of a body.
  *
@@ -124,6 +218,7 @@ rgb_color_t body_get_color(body_t *body);
 /**
  * Translates a body to a new position.
  * The position is specified by the position of the body's center of mass.
+ * Wakes the body, since its contacts may have changed.
  *
  * @param body a pointer to a body returned from body_init_shape()
  * @param x the body's new centroid
@@ -141,6 +236,7 @@ void body_move_centroid(body_t *body, vector_t x);
 
 /**
  * Changes a body's velocity (the time-derivative of its position).
+ * Wakes the body if the new velocity is nonzero.
  *
  * @param body a pointer to a body returned from body_init_shape()
  * @param v the body's new velocity
@@ -184,25 +280,212 @@ void body_add_force(body_t *body, vector_t force);
  * which is useful for modeling collisions.
  * If multiple impulses are applied in the same tick, they should be added.
  * Should not change the body's position or velocity; see body_tick().
+ * A nonzero impulse wakes the body.
  *
  * @param body a pointer to a body returned from body_init_shape()
  * @param impulse the impulse vector to apply
  */
 void body_add_impulse(body_t *body, vector_t impulse);
 
+/**
+ * Gets the total force applied to a body so far this tick.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the sum of the forces passed to body_add_force() since the last tick
+ */
+vector_t body_get_force(body_t *body);
+
+/**
+ * Gets the total impulse applied to a body so far this tick.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the sum of the impulses passed to body_add_impulse() since the last
+ *   tick
+ */
+vector_t body_get_impulse(body_t *body);
+
 /**
  * Updates the body after a given time interval has elapsed.
  * Sets acceleration and velocity according to the forces and impulses
  * applied to the body during the tick.
  * The body should be translated at the *average* of the velocities before
  * and after the tick.
+ * Linear drag (see body_set_drag()) is integrated exactly, as an
+ * exponential decay of the velocity towards the terminal velocity.
  * Resets the forces and impulses accumulated on the body.
+ * Sleeping bodies only have their forces reset.
  *
  * @param body the body to tick
  * @param dt the number of seconds elapsed since the last tick
  */
 void body_tick(body_t *body, double dt);
 
+/**
+ * Resets the forces, impulses and acceleration accumulated on a body
+ * without moving it. Used by integrators that step bodies themselves.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ */
+void body_clear_forces(body_t *body);
+
+/**
+ * Sets a body's linear drag coefficient.
+ * Drag produces a force of -gamma * velocity, but rather than being applied
+ * as a force it is integrated in closed form, so it stays exact and stable
+ * however large the tick is.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @param gamma the proportionality constant between drag and velocity
+ */
+void body_set_drag(body_t *body, double gamma);
+
+/**
+ * Gets a body's linear drag coefficient.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the proportionality constant between drag and velocity
+ */
+double body_get_drag(body_t *body);
+
+/**
+ * Applies a body's drag to a velocity over a time interval,
+ * in the presence of a constant acceleration.
+ * With drag rate c = gamma / mass, the velocity decays exponentially towards
+ * the terminal velocity acc / c.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @param vel the velocity at the start of the interval
+ * @param acc the acceleration from all other forces
+ * @param dt the length of the interval
+ * @param displacement if non-NULL, set to how far the body moves
+ * @return the velocity at the end of the interval
+ */
+vector_t body_drag_velocity(body_t *body, vector_t vel, vector_t acc, double dt,
+                            vector_t *displacement);
+
+/**
+ * Returns whether a body is asleep.
+ * Sleeping bodies are not integrated by body_tick()
+ * and are skipped by collision checks against other sleeping bodies.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return whether the body is sleeping
+ */
+bool body_is_sleeping(body_t *body);
+
+/**
+ * Puts a body to sleep, stopping it and ignoring forces until it is woken.
+ * Usually done by the scene once a whole contact island has come to rest.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ */
+void body_sleep(body_t *body);
+
+/**
+ * Wakes a sleeping body up and restarts its rest timer.
+ * Does nothing to a body that is already awake.
+ * body_add_impulse(), body_set_velocity() and body_set_centroid() wake the
+ * body automatically; contact with an awake body wakes its whole island.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ */
+void body_wake(body_t *body);
+
+/**
+ * Gets how long a body has been moving slowly enough to fall asleep.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the number of seconds the body has been at rest
+ */
+double body_get_rest_time(body_t *body);
+
+/**
+ * Sets how long a body has been moving slowly enough to fall asleep.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @param time the number of seconds the body has been at rest
+ */
+void body_set_rest_time(body_t *body, double time);
+
+/**
+ * Gets the island a body was assigned to by the last scene tick.
+ * Bodies in the same island are connected by chains of touching contacts.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the island's index
+ */
+size_t body_get_island(body_t *body);
+
+/**
+ * Assigns a body to an island. Used by the scene's island pass.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @param island the island's index
+ */
+void body_set_island(body_t *body, size_t island);
+
+/**
+ * Sets which collision categories a body belongs to and which it collides
+ * with. Two bodies are paired by the scene's broad phase when each one's
+ * category is in the other's mask and a collision rule exists for them
+ * (see scene_add_collision_rule()).
+ * New bodies have category 0, so they only collide through
+ * explicitly registered collision forces.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @param category a bitset of the categories the body belongs to
+ * @param mask a bitset of the categories the body collides with
+ */
+void body_set_collision_filter(body_t *body, uint32_t category, uint32_t mask);
+
+/**
+ * Gets the collision categories a body belongs to.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the category bitset
+ */
+uint32_t body_get_category(body_t *body);
+
+/**
+ * Gets the collision categories a body collides with.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the mask bitset
+ */
+uint32_t body_get_mask(body_t *body);
+
+/**
+ * Makes a body a sensor, or a regular body again.
+ * Sensors take part in the broad phase like other bodies, but instead of
+ * colliding they report trigger events when bodies start or stop overlapping
+ * them (see scene_get_trigger_event()). They need no collision rule, only
+ * matching collision filters.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @param sensor whether the body should be a sensor
+ */
+void body_set_sensor(body_t *body, bool sensor);
+
+/**
+ * Returns whether a body is a sensor.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return whether the body reports trigger events instead of colliding
+ */
+bool body_is_sensor(body_t *body);
+
+/**
+ * Gets a counter that changes whenever a body's motion is changed from
+ * outside its own integration: by body_set_velocity() with a new velocity,
+ * body_set_centroid(), a rotation or a nonzero body_add_impulse().
+ * Lets predictions based on the body's motion (see toi.h) tell when they
+ * have gone stale.
+ *
+ * @param body a pointer to a body returned from body_init_shape()
+ * @return the motion version
+ */
+size_t body_get_version(body_t *body);
+
 /**
  * Gets the current acceleration of a body.
  *
@@ -241,6 +524,65 @@ void body_set_texture_scaled(body_t *body, const char *texture_file,
                              double scaling);
 
 bool body_has_sprite(body_t *body);
+
+/**
+ * Chooses whether a body collides with the opaque pixels of its texture
+ * (see sdl_create_texture_with_mask()) rather than its whole polygon.
+ * Only sensible when the shape is the texture's rectangle, which is why
+ * body_init_texture_path_scaled() turns it on. Each pixel of the mask
+ * covers the sprite's scaling in scene units, like the drawn texture.
+ * While the body is rotated, its polygon is used instead.
+ *
+ * @param body a pointer to a body with a texture
+ * @param pixel_collision whether to collide with the texture's pixels
+ */
+void body_set_pixel_collision(body_t *body, bool pixel_collision);
+
+/**
+ * Returns whether a body collides with the opaque pixels of its texture.
+ *
+ * @param body a pointer to a body
+ * @return whether body_set_pixel_collision() is on
+ */
+bool body_has_pixel_collision(body_t *body);
+
+/**
+ * Marks a body as part of a scene's unchanging scenery, like a wall.
+ * Static bodies are drawn once into the renderer's cached static layer
+ * (see sdl_render_scene()) instead of every frame. Moving a static body
+ * redraws the layer; other changes, like a new color, need
+ * sdl_invalidate_static_layer().
+ *
+ * @param body a pointer to a body
+ * @param is_static whether the body is static
+ */
+void body_set_static(body_t *body, bool is_static);
+
+/**
+ * Returns whether a body is part of its scene's unchanging scenery.
+ *
+ * @param body a pointer to a body
+ * @return whether body_set_static() is on
+ */
+bool body_is_static(body_t *body);
+
+/**
+ * Runs the narrow phase between two bodies.
+ * Polygons are tested first (see find_collision_view()), reading the
+ * bodies' vertices without allocating; if they touch and either
+ * body collides with pixels, the contact only counts if an opaque pixel
+ * overlaps the other body's pixels or polygon. The axis still comes from the
+ * polygons, but the depth of a pixel contact is capped at one pixel, since
+ * the polygons' depth measures to the edge of the image's rectangle.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param cache if non-NULL, the pair's collision cache
+ * @return whether the bodies are touching, and if so, the collision axis
+ *   pointing from body1 towards body2
+ */
+collision_info_t body_find_collision(body_t *body1, body_t *body2,
+                                     collision_cache_t *cache);
 /**
  * @brief prints the body info for debugging
  *
@@ -256,4 +598,66 @@ void body_print(body_t *body);
  */
 void body_change_direction(body_t *body, vector_t dir);
 
+/**
+ * Allocates an empty body pool.
+ *
+ * @return the new pool
+ */
+body_pool_t *body_pool_init(void);
+
+/**
+ * Releases the memory allocated for a pool.
+ * The bodies themselves are not freed; free them first, since a body's
+ * state lives in the pool until it is removed from it.
+ *
+ * @param pool a pointer to a pool returned from body_pool_init()
+ */
+void body_pool_free(body_pool_t *pool);
+
+/**
+ * Moves a body's state into the last slot of a pool.
+ * A body can be in at most one pool.
+ *
+ * @param pool the pool
+ * @param body a body that is not in a pool
+ */
+void body_pool_add(body_pool_t *pool, body_t *body);
+
+/**
+ * Moves a body's state out of a pool and back into the body,
+ * shifting the later slots down like list_remove().
+ *
+ * @param pool the pool
+ * @param index the slot of the body
+ * @return the body, which is no longer in the pool
+ */
+body_t *body_pool_remove(body_pool_t *pool, size_t index);
+
+/**
+ * Gets the number of bodies in a pool.
+ *
+ * @param pool the pool
+ * @return the number of bodies
+ */
+size_t body_pool_size(body_pool_t *pool);
+
+/**
+ * Gets the body whose state is in a slot of a pool.
+ *
+ * @param pool the pool
+ * @param index the slot
+ * @return the body
+ */
+body_t *body_pool_get(body_pool_t *pool, size_t index);
+
+/**
+ * Sorts a pool's slots along a Z-order (Morton) curve of the bodies'
+ * centroids, so bodies that are close in the scene are close in memory.
+ * Bodies in the same 16 pixel cell keep their relative order.
+ * Each body's key is computed once per sort, not on every comparison.
+ *
+ * @param pool the pool
+ */
+void body_pool_sort(body_pool_t *pool);
+
 #endif // #ifndef __BODY_H__
@@ -0,0 +1,219 @@
+#ifndef __BROADPHASE_H__
+#define __BROADPHASE_H__
+
+#include "body.h"
+#include "list.h"
+#include "solver.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A function called when a collision occurs.
+ * @param body1 the first body passed to create_collision()
+ * @param body2 the second body passed to create_collision()
+ * @param axis a unit vector pointing from body1 towards body2
+ *   that defines the direction the two bodies are colliding in
+ * @param aux the auxiliary value passed to create_collision()
+ */
+typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
+                                    void *aux);
+
+/**
+ * Reported when a body starts or stops overlapping a sensor.
+ * The bodies stay valid until the end of the tick that reported the event;
+ * bodies removed from the scene produce no end event.
+ */
+typedef struct trigger_event {
+  body_t *sensor;
+  body_t *other;
+  bool begin;
+} trigger_event_t;
+
+/**
+ * Finds the pairs of bodies that need a narrow phase, without registering
+ * every pair by hand.
+ * Bodies are swept along x in a list kept sorted by the left edge of their
+ * bounding boxes (sweep and prune); since bodies move little between ticks,
+ * an insertion sort restores the order in close to linear time.
+ * Two bodies interact when each one's category is in the other's mask
+ * (see body_set_collision_filter()) and a rule exists for their categories.
+ * Every pair whose bounding boxes overlap keeps its state (its solver contact
+ * or whether its handler has fired) until the boxes separate.
+ * Pairs involving a sensor body (see body_set_sensor()) only need matching
+ * filters, not a rule, and produce trigger events instead of collisions.
+ */
+typedef struct broadphase broadphase_t;
+
+/**
+ * Allocates memory for an empty broad phase.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new broad phase
+ */
+broadphase_t *broadphase_init(void);
+
+/**
+ * Releases the memory allocated for a broad phase,
+ * including its rules' auxiliary values and pair states.
+ * Does not free the bodies.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ */
+void broadphase_free(broadphase_t *bp);
+
+/**
+ * Adds a rule for how bodies in two categories interact.
+ * If handler is NULL, touching pairs are resolved physically by the solver
+ * with the given elasticity. Otherwise, the handler is called whenever a
+ * pair starts touching, like create_collision() does.
+ * When several rules match a pair, the first one added is used.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param category1 the categories of the body passed first to the handler
+ * @param category2 the categories of the body passed second to the handler
+ * @param elasticity the coefficient of restitution for physics rules
+ * @param handler the handler for handler rules, or NULL
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void broadphase_add_rule(broadphase_t *bp, uint32_t category1,
+                         uint32_t category2, double elasticity,
+                         collision_handler_t handler, void *aux,
+                         free_func_t freer);
+
+/**
+ * Starts tracking a body.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param body the body to track
+ */
+void broadphase_add_body(broadphase_t *bp, body_t *body);
+
+/**
+ * Stops tracking a body and drops every pair state and pending trigger event
+ * that involves it.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param body the body to forget
+ */
+void broadphase_remove_body(broadphase_t *bp, body_t *body);
+
+/**
+ * A function called for each body found by broadphase_query().
+ * Returns false to stop the query early.
+ */
+typedef bool (*broadphase_query_t)(body_t *body, void *aux);
+
+/**
+ * Refreshes the bounding boxes of awake bodies and re-sorts them.
+ * Nearly sorted from the last tick, so this is close to a single pass.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ */
+void broadphase_refresh(broadphase_t *bp);
+
+/**
+ * Finds the bodies whose bounding boxes, as of the last broadphase_refresh(),
+ * overlap a box. Binary searches the sorted boxes, so only bodies near the
+ * box along x are visited. Does not allocate.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param box the box to search
+ * @param callback called for each overlapping body until it returns false
+ * @param aux an auxiliary value to pass to the callback
+ */
+void broadphase_query(broadphase_t *bp, aabb_t box, broadphase_query_t callback,
+                      void *aux);
+
+/**
+ * Finds the overlapping pairs and runs their narrow phase.
+ * Bounding boxes of sleeping bodies are not refreshed, and pairs of sleeping
+ * bodies keep their state without a narrow phase.
+ * Touching physics pairs are added to the solver; handler pairs call their
+ * handler when they start touching. Trigger events are appended to those
+ * already reported, until broadphase_clear_events().
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param solver the solver for this tick's contacts
+ */
+void broadphase_update(broadphase_t *bp, solver_t *solver);
+
+/**
+ * Returns whether two bodies would interact if they touched:
+ * their collision filters match and either one is a sensor
+ * or a rule exists for their categories.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return whether the pair has a sensor or a rule
+ */
+bool broadphase_interacts(broadphase_t *bp, body_t *body1, body_t *body2);
+
+/**
+ * Resolves two bodies meeting along an axis, without a narrow phase.
+ * Used when the time of impact is known in advance (see toi.h):
+ * a sensor pair that isn't already overlapping reports a begin event and is
+ * kept until broadphase_separate() (or a broadphase_update() that finds its
+ * boxes apart), a handler rule calls its handler,
+ * and a physics rule changes the bodies' velocities directly by the impulse
+ * -(1 + elasticity) * (approach speed) / (sum of inverse masses).
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param axis a unit vector pointing from body1 towards body2
+ */
+void broadphase_impact(broadphase_t *bp, body_t *body1, body_t *body2,
+                       vector_t axis);
+
+/**
+ * Ends a sensor pair's overlap, found without a narrow phase
+ * (see broadphase_impact()), reporting its end event.
+ * Does nothing for pairs that aren't overlapping sensor pairs.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+void broadphase_separate(broadphase_t *bp, body_t *body1, body_t *body2);
+
+/**
+ * Discards the trigger events reported so far.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ */
+void broadphase_clear_events(broadphase_t *bp);
+
+/**
+ * Gets the number of trigger events reported since the last
+ * broadphase_clear_events().
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @return the number of events
+ */
+size_t broadphase_events(broadphase_t *bp);
+
+/**
+ * Gets a trigger event reported since the last broadphase_clear_events(),
+ * in the order they happened.
+ * Asserts that the index is valid.
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @param index the index of the event (starting at 0)
+ * @return the event
+ */
+trigger_event_t broadphase_get_event(broadphase_t *bp, size_t index);
+
+/**
+ * Gets the number of pairs whose bounding boxes overlapped
+ * in the last broadphase_update().
+ *
+ * @param bp a pointer to a broad phase returned from broadphase_init()
+ * @return the number of live pair states
+ */
+size_t broadphase_pairs(broadphase_t *bp);
+
+#endif // #ifndef __BROADPHASE_H__
@@ -4,6 +4,7 @@
 #include "list.h"
 #include "vector.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * Represents the status of a collision between two shapes.
@@ -19,7 +20,47 @@ typedef struct {
    * If collided is false, this value is undefined.
    */
   vector_t axis;
+  /**
+   * If the shapes are colliding, how far they overlap along the axis,
+   * i.e. how far one would have to move along it to separate them.
+   * If collided is false, this value is undefined.
+   */
+  double depth;
 } collision_info_t;
+
+/**
+ * A convex polygon read in place from an array of vertices in
+ * counterclockwise order, so callers that already have the vertices
+ * (e.g. body_find_collision()) need not copy them into a list.
+ */
+typedef struct {
+  const vector_t *points;
+  size_t size;
+} polygon_view_t;
+
+/**
+ * What a pair of shapes learned from its last find_collision(), so the next
+ * check can start from it. Most pairs stay separated along the same axis
+ * from one tick to the next, so they are ruled out after one projection.
+ * Each pair being checked keeps its own cache (see contact_init()).
+ */
+typedef struct {
+  /**
+   * The edge whose normal last separated the shapes, counting the edges of
+   * shape1 first and then those of shape2; SIZE_MAX if there is none.
+   */
+  size_t axis_index;
+  /** The direction in which GJK last found the shapes apart, or zero */
+  vector_t direction;
+} collision_cache_t;
+
+/**
+ * Creates an empty collision cache.
+ *
+ * @return a cache with no separating axis yet
+ */
+collision_cache_t collision_cache_init(void);
+
 /**
  * Computes the projection of a shape onto an aixs
  *
@@ -29,17 +70,68 @@ typedef struct {
  */
 vector_t shape_projection(vector_t *axis, list_t *shape);
 
+/**
+ * Computes the status of the collision between two convex polygons
+ * with the separating axis test.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @param cache if non-NULL, the pair's cache; its separating axis is tested
+ *   first, and it is updated with the axis found this time
+ * @return the same as find_collision()
+ */
+collision_info_t find_collision_sat(polygon_view_t shape1,
+                                    polygon_view_t shape2,
+                                    collision_cache_t *cache);
+
+/**
+ * Computes the status of the collision between two convex polygons
+ * with GJK, and their penetration with EPA. Each iteration only needs the
+ * vertex of each shape furthest along a direction, so this scales better
+ * than the separating axis test for shapes with many vertices.
+ * See https://en.wikipedia.org/wiki/Gilbert%E2%80%93Johnson%E2%80%93Keerthi_distance_algorithm.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @param cache if non-NULL, the pair's cache; GJK starts its search from the
+ *   last separating direction
+ * @return the same as find_collision()
+ */
+collision_info_t find_collision_gjk(polygon_view_t shape1,
+                                    polygon_view_t shape2,
+                                    collision_cache_t *cache);
+
+/**
+ * Computes the status of the collision between two convex polygons,
+ * reading their vertices in place.
+ * Small shapes use find_collision_sat(); once the shapes have more than
+ * 24 vertices between them, find_collision_gjk() is used instead.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @param cache if non-NULL, the pair's cache
+ * @return the same as find_collision()
+ */
+collision_info_t find_collision_view(polygon_view_t shape1,
+                                     polygon_view_t shape2,
+                                     collision_cache_t *cache);
+
 /**
  * Computes the status of the collision between two convex polygons.
  * The shapes are given as lists of vertices in counterclockwise order.
  * There is an edge between each pair of consecutive vertices,
  * and one between the first vertex and the last vertex.
+ * Same as find_collision_view(), after copying the vertices out of the
+ * lists.
  *
  * @param shape1 the first shape
  * @param shape2 the second shape
+ * @param cache if non-NULL, the pair's cache; its separating axis is tested
+ *   first, and it is updated with the axis found this time
  * @return whether the shapes are colliding, and if so, the collision axis.
  * The axis should be a unit vector pointing from shape1 towards shape2.
  */
-collision_info_t find_collision(list_t *shape1, list_t *shape2);
+collision_info_t find_collision(list_t *shape1, list_t *shape2,
+                                collision_cache_t *cache);
 
 #endif // #ifndef __COLLISION_H__
@@ -3,17 +3,6 @@
 
 #include "scene.h"
 
-/**
- * A function called when a collision occurs.
- * @param body1 the first body passed to create_collision()
- * @param body2 the second body passed to create_collision()
- * @param axis a unit vector pointing from body1 towards body2
- *   that defines the direction the two bodies are colliding in
- * @param aux the auxiliary value passed to create_collision()
- */
-typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
-                                    void *aux);
-
 /**
  * A force is made up of a force_creator_t (forcer), auxiliary values,
  * and a free function.
@@ -35,6 +24,11 @@ typedef struct aux aux_t;
  */
 typedef struct collision_aux collision_aux_t;
 
+/**
+ * Contains the scene and persistent contact state for a physics collision.
+ */
+typedef struct physics_aux physics_aux_t;
+
 /**
  * Releases the memory allocated for an aux struct with multiple values.
  *
@@ -50,6 +44,14 @@ void aux_free(aux_t *aux);
  */
 void collision_aux_free(collision_aux_t *aux);
 
+/**
+ * Releases the memory allocated for a physics collision aux,
+ * including its contact.
+ *
+ * @param aux a pointer to the aux of a create_physics_collision() force
+ */
+void physics_aux_free(physics_aux_t *aux);
+
 /**
  * Allocates memory for an aux with the given parameters (2 bodies).
  *
@@ -120,6 +122,27 @@ list_t *force_get_body(force_t *force, size_t index);
  */
 bool force_is_body_in_force(force_t *force, body_t *body);
 
+/**
+ * Returns whether a force ties its bodies' motion together, like a spring or
+ * gravity does. Collision forces only do so while their bodies are touching,
+ * which the scene learns from the solver instead.
+ *
+ * @param force the force
+ * @return whether the force's bodies belong in the same island
+ */
+bool force_links_bodies(force_t *force);
+
+/**
+ * Returns whether a force only depends on the positions of its bodies,
+ * like gravity and springs. Integrators with several stages per tick
+ * (see integrator.h) re-evaluate such forces at every stage; all other
+ * forces are held constant over the tick.
+ *
+ * @param force the force
+ * @return whether the force is a field force
+ */
+bool force_is_field(force_t *force);
+
 /**
  * Applies a force creator to its aux values.
  *
@@ -142,6 +165,7 @@ void spring_force(aux_t *aux_val);
 /**
  * A function which computes drag force for the body.
  * Takes in an auxiliary value that can store parameters or state (only 1 body).
+ * create_drag() no longer uses it; drag is integrated by the body itself.
  */
 void drag_force(aux_t *aux_val);
 
@@ -176,10 +200,11 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
 
 /**
- * Adds a force creator to a scene that applies a drag force on a body.
- * The force creator will be called each tick
- * to compute the drag force on the body proportional to its velocity.
- * The force points opposite the body's velocity.
+ * Applies a drag force on a body, proportional to its velocity and
+ * pointing opposite it.
+ * Adds gamma to the body's drag coefficient (see body_set_drag()),
+ * which body_tick() and the scene's integrators treat in closed form,
+ * rather than adding a force creator.
  *
  * @param scene the scene containing the bodies
  * @param gamma the proportionality constant between force and velocity
@@ -222,13 +247,12 @@ void create_destructive_collision(scene_t *scene, body_t *body1, body_t *body2);
 /**
  * Adds a force creator to a scene that applies impulses
  * to resolve collisions between two bodies in the scene.
- * This should be represented as an on-collision callback
- * registered with create_collision().
- *
- * You may remember from project01 that you should avoid applying impulses
- * multiple times while the bodies are still colliding.
- * You should also have a special case that allows either body1 or body2
- * to have mass INFINITY, as this is useful for simulating walls.
+ * Every tick the bodies overlap, their contact is handed to the scene's
+ * solver (see solver_solve()), which resolves all contacts together.
+ * Impulses are only applied while the bodies approach each other,
+ * so a contact that lasts several ticks bounces once.
+ * Either body1 or body2 may have mass INFINITY, which is useful for
+ * simulating walls.
  *
  * @param scene the scene containing the bodies
  * @param elasticity the "coefficient of restitution" of the collision;
@@ -241,9 +265,19 @@ void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
 
 /**
  * Applies collision force on the bodies.
+ * Pairs where both bodies are asleep are not checked.
  *
  * @param other_aux aux information
  */
 void collision_force_creator(collision_aux_t *other_aux);
 
+/**
+ * Runs the narrow phase for a physics collision and,
+ * if the bodies are touching, adds their contact to the scene's solver.
+ * Pairs where both bodies are asleep are skipped.
+ *
+ * @param aux the aux of a create_physics_collision() force
+ */
+void physics_collision_force_creator(physics_aux_t *aux);
+
 #endif // #ifndef __FORCES_H__
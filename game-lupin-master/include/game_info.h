@@ -4,6 +4,7 @@
 #include "color.h"
 #include "vector.h"
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 static const char WINDOW_TITLE[] = "Pong Ping";
@@ -69,6 +70,10 @@ static const double PELLET_MAX_POS_SCREEN_BUFFER = 100;
 static const double WALL_THICCNESS = 50;
 static const rgb_color_t WALL_COLOR = {.r = 1, .g = 1, .b = 1};
 
+static const uint32_t PADDLE_CATEGORY = 1 << 0;
+static const uint32_t PELLET_CATEGORY = 1 << 1;
+static const uint32_t WALL_CATEGORY = 1 << 2;
+
 static const vector_t SCORE_POS_P1 = {WINDOW_WIDTH / 2 - 20,
                                       WINDOW_HEIGHT - 20};
 static const vector_t SCORE_POS_P2 = {WINDOW_WIDTH / 2 + 20,
@@ -94,6 +99,16 @@ static const double PACMAN_TEXTURE_SCALING = 1;
 static const char *YOSHI_P1_TEXTURE_FILE = "./extras/yoshi_p1.png";
 static const char *YOSHI_P2_TEXTURE_FILE = "./extras/yoshi_p2.png";
 static const double YOSHI_TEXTURE_SCALING = 1;
+// Sprite images packed into one atlas page at startup
+// (see texture_cache_pack())
+static const char *ATLAS_FILES[] = {
+    "./extras/pellet.png",        "./extras/kirby_p1.png",
+    "./extras/kirby_p2.png",      "./extras/diddy_kong_p1.png",
+    "./extras/diddy_kong_p2.png", "./extras/pacman_p1.png",
+    "./extras/pacman_p2.png",     "./extras/yoshi_p1.png",
+    "./extras/yoshi_p2.png"};
+static const size_t ATLAS_FILE_COUNT =
+    sizeof(ATLAS_FILES) / sizeof(ATLAS_FILES[0]);
 
 static const char *MAIN_MENU_FILE = "./extras/main_menu.png";
 static const char *CHARACTER_SELECTION_FILE =
@@ -0,0 +1,76 @@
+#ifndef __GLYPH_ATLAS_H__
+#define __GLYPH_ATLAS_H__
+
+#include "vector.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stddef.h>
+
+/**
+ * Every printable ASCII glyph of a font, rasterised once into one texture,
+ * along with a batch of quads waiting to be drawn from it.
+ * Strings are laid out from the cached glyph metrics, so drawing text that
+ * changes every frame allocates no surfaces or textures, and everything
+ * queued since the last flush is drawn with one SDL_RenderGeometry() call.
+ */
+typedef struct glyph_atlas glyph_atlas_t;
+
+/**
+ * Rasterises the printable ASCII glyphs of a font into an atlas texture.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param renderer the renderer that will draw the atlas
+ * @param font the font, which must stay open while the atlas is used
+ * @return the new atlas
+ */
+glyph_atlas_t *glyph_atlas_init(SDL_Renderer *renderer, TTF_Font *font);
+
+/**
+ * Releases the memory allocated for an atlas, including its texture.
+ *
+ * @param atlas a pointer to an atlas returned from glyph_atlas_init()
+ */
+void glyph_atlas_free(glyph_atlas_t *atlas);
+
+/**
+ * Computes how wide a string is when laid out by glyph_atlas_queue().
+ *
+ * @param atlas the atlas
+ * @param str the string
+ * @return the width in pixels
+ */
+int glyph_atlas_measure(glyph_atlas_t *atlas, const char *str);
+
+/**
+ * Adds a string to the atlas's batch. Characters the atlas has no glyph for
+ * are drawn as '?'.
+ * The batch only allocates when it outgrows every earlier frame
+ * (see quad_batch.h).
+ *
+ * @param atlas the atlas
+ * @param str the string
+ * @param pos the top left corner of the string in pixels
+ * @param color the color to tint the glyphs with; an alpha of 0 is drawn
+ *   opaque, as SDL_ttf does
+ */
+void glyph_atlas_queue(glyph_atlas_t *atlas, const char *str, vector_t pos,
+                       SDL_Color color);
+
+/**
+ * Gets the number of glyphs waiting in an atlas's batch.
+ *
+ * @param atlas the atlas
+ * @return the number of glyphs queued since the last flush
+ */
+size_t glyph_atlas_queued(glyph_atlas_t *atlas);
+
+/**
+ * Draws every queued glyph with one SDL_RenderGeometry() call
+ * and empties the batch. Does nothing if the batch is empty.
+ *
+ * @param atlas the atlas
+ * @param renderer the renderer to draw with
+ */
+void glyph_atlas_flush(glyph_atlas_t *atlas, SDL_Renderer *renderer);
+
+#endif // #ifndef __GLYPH_ATLAS_H__
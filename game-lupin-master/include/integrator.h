@@ -0,0 +1,74 @@
+#ifndef __INTEGRATOR_H__
+#define __INTEGRATOR_H__
+
+#include "list.h"
+#include <stddef.h>
+
+/**
+ * The schemes a scene can use to advance its bodies each tick,
+ * from cheapest to most accurate.
+ * INTEGRATOR_AVERAGE is body_tick(): one force evaluation, moving at the
+ * average of the old and new velocities.
+ * INTEGRATOR_SEMI_IMPLICIT_EULER updates the velocity first and moves at the
+ * new one; it is as cheap and conserves energy better in orbits.
+ * INTEGRATOR_VELOCITY_VERLET re-evaluates field forces (see force_is_field())
+ * once at the new positions; second order.
+ * INTEGRATOR_RK4 re-evaluates field forces three times; fourth order,
+ * for scenes dominated by gravity.
+ * Forces that aren't field forces (collisions, custom creators) and impulses
+ * are held constant over the tick by every scheme, and drag is always
+ * integrated in closed form.
+ */
+typedef enum {
+  INTEGRATOR_AVERAGE,
+  INTEGRATOR_SEMI_IMPLICIT_EULER,
+  INTEGRATOR_VELOCITY_VERLET,
+  INTEGRATOR_RK4
+} integrator_t;
+
+/**
+ * The per-body scratch state an integrator needs during a tick.
+ * Owned by the scene and reused every tick.
+ */
+typedef struct integration integration_t;
+
+/**
+ * Allocates memory for integration scratch state.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new state
+ */
+integration_t *integration_init(void);
+
+/**
+ * Releases the memory allocated for integration scratch state.
+ *
+ * @param integration a pointer returned from integration_init()
+ */
+void integration_free(integration_t *integration);
+
+/**
+ * Records the field forces acting on each body at the start of a tick.
+ * Must be called after the field forces are applied and before any other
+ * force, so the integrator can tell the two apart.
+ *
+ * @param integration a pointer returned from integration_init()
+ * @param bodies the bodies of the scene
+ */
+void integration_record_field_forces(integration_t *integration,
+                                     list_t *bodies);
+
+/**
+ * Advances every awake body by dt with the given scheme, then resets the
+ * forces and impulses accumulated on them.
+ *
+ * @param integration a pointer returned from integration_init()
+ * @param integrator the scheme to use
+ * @param bodies the bodies of the scene
+ * @param forces the force creators of the scene, for re-evaluating fields
+ * @param dt the length of the tick
+ */
+void integration_step(integration_t *integration, integrator_t integrator,
+                      list_t *bodies, list_t *forces, double dt);
+
+#endif // #ifndef __INTEGRATOR_H__
@@ -0,0 +1,63 @@
+#ifndef __ISLAND_H__
+#define __ISLAND_H__
+
+#include "forces.h"
+#include "list.h"
+#include "solver.h"
+#include <stddef.h>
+
+/**
+ * Groups bodies into islands and puts islands to sleep once every body in
+ * them has been at rest for long enough.
+ * Bodies are linked by touching contacts and by force creators that tie
+ * their motion together (see force_links_bodies()), so a black hole keeps
+ * following the pellet it attracts.
+ * Bodies with infinite mass never join islands, since they can't pass
+ * motion from one body to another (a wall doesn't link everything touching
+ * it); they fall asleep on their own.
+ */
+typedef struct islands islands_t;
+
+/**
+ * Allocates memory for the island bookkeeping of a scene.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new islands
+ */
+islands_t *islands_init(void);
+
+/**
+ * Releases the memory allocated for islands.
+ *
+ * @param islands a pointer to islands returned from islands_init()
+ */
+void islands_free(islands_t *islands);
+
+/**
+ * Updates the sleep state of every body after a tick.
+ * Each body's rest time grows while it moves slower than the sleep
+ * thresholds. Islands are then built with union-find over the linking
+ * forces and the solver's touching contacts: an island whose bodies have all rested long enough
+ * falls asleep, and an island with any awake body is woken as a whole,
+ * which is how contact with an awake body wakes sleeping ones.
+ * Sets every body's island with body_set_island().
+ *
+ * @param islands a pointer to islands returned from islands_init()
+ * @param bodies the bodies of the scene
+ * @param forces the force creators of the scene
+ * @param solver the solver holding this tick's contacts
+ * @param dt the length of the tick
+ */
+void islands_update(islands_t *islands, list_t *bodies, list_t *forces,
+                    solver_t *solver, double dt);
+
+/**
+ * Gets the number of islands found by the last islands_update(),
+ * counting every infinite-mass body as its own island.
+ *
+ * @param islands a pointer to islands returned from islands_init()
+ * @return the number of islands
+ */
+size_t islands_count(islands_t *islands);
+
+#endif // #ifndef __ISLAND_H__
@@ -0,0 +1,105 @@
+#ifndef __MASK_H__
+#define __MASK_H__
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A 1-bit collision mask of an image: which pixels are opaque.
+ * Each row is packed into 64-bit words (bit x % 64 of word x / 64 is pixel
+ * x), so testing two masks for overlap takes a few word operations per row.
+ * Rows run from the top of the image down, as in the image itself.
+ */
+typedef struct mask mask_t;
+
+/**
+ * Allocates memory for a mask with every pixel clear.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param width the width in pixels
+ * @param height the height in pixels
+ * @return the new mask
+ */
+mask_t *mask_init(size_t width, size_t height);
+
+/**
+ * Builds the mask of an image's opaque pixels.
+ *
+ * @param surface an image with SDL_PIXELFORMAT_RGBA32 pixels
+ * @param alpha_threshold the lowest alpha that counts as opaque
+ * @return the new mask
+ */
+mask_t *mask_from_surface(SDL_Surface *surface, uint8_t alpha_threshold);
+
+/**
+ * Releases the memory allocated for a mask.
+ *
+ * @param mask a pointer to a mask returned from mask_init()
+ */
+void mask_free(mask_t *mask);
+
+/**
+ * Gets the width of a mask.
+ *
+ * @param mask a pointer to a mask returned from mask_init()
+ * @return the width in pixels
+ */
+size_t mask_width(mask_t *mask);
+
+/**
+ * Gets the height of a mask.
+ *
+ * @param mask a pointer to a mask returned from mask_init()
+ * @return the height in pixels
+ */
+size_t mask_height(mask_t *mask);
+
+/**
+ * Returns whether a pixel is set. Pixels outside the mask are clear.
+ *
+ * @param mask a pointer to a mask returned from mask_init()
+ * @param x the column, from the left
+ * @param y the row, from the top
+ * @return whether the pixel is opaque
+ */
+bool mask_get(mask_t *mask, int x, int y);
+
+/**
+ * Sets or clears a pixel. Asserts that the pixel is inside the mask.
+ *
+ * @param mask a pointer to a mask returned from mask_init()
+ * @param x the column, from the left
+ * @param y the row, from the top
+ * @param value whether the pixel is opaque
+ */
+void mask_set(mask_t *mask, int x, int y, bool value);
+
+/**
+ * Returns whether any pixel of a row is set between two columns.
+ * Columns outside the mask are ignored.
+ *
+ * @param mask a pointer to a mask returned from mask_init()
+ * @param y the row, from the top
+ * @param x0 the first column
+ * @param x1 one past the last column
+ * @return whether a pixel in [x0, x1) is opaque
+ */
+bool mask_row_any(mask_t *mask, int y, int x0, int x1);
+
+/**
+ * Returns whether two masks share an opaque pixel, with the top left corner
+ * of the second mask at (dx, dy) in the first mask's pixels.
+ * Rows that can't overlap are skipped, so this is cheap when the masks
+ * barely overlap.
+ *
+ * @param mask1 the first mask
+ * @param mask2 the second mask
+ * @param dx the column of mask2's left edge in mask1
+ * @param dy the row of mask2's top edge in mask1
+ * @return whether the masks overlap
+ */
+bool mask_overlap(mask_t *mask1, mask_t *mask2, int dx, int dy);
+
+#endif // #ifndef __MASK_H__
@@ -5,6 +5,26 @@
 #include "vec_list.h"
 #include "vector.h"
 
+/**
+ * An axis-aligned bounding box, given by its bottom left and top right corners.
+ */
+typedef struct {
+  vector_t min;
+  vector_t max;
+} aabb_t;
+
+/**
+ * The mass properties of a polygon with uniform density.
+ */
+typedef struct {
+  /** The (unsigned) area of the polygon */
+  double area;
+  /** The center of mass of the polygon */
+  vector_t centroid;
+  /** The smallest axis-aligned box containing every vertex */
+  aabb_t bounds;
+} polygon_props_t;
+
 /**
  * Computes the area of a polygon.
  * See https://en.wikipedia.org/wiki/Shoelace_formula#Statement.
@@ -27,6 +47,90 @@ double polygon_area(list_t *polygon);
  */
 vector_t polygon_centroid(list_t *polygon);
 
+/**
+ * Computes the area, centroid and bounding box of a polygon
+ * in a single pass over its vertices.
+ * Prefer this over separate polygon_area() and polygon_centroid() calls,
+ * since polygon_centroid() has to compute the area as well.
+ *
+ * @param polygon the list of vertices that make up the polygon,
+ * listed in a counterclockwise direction
+ * @return the area, centroid and bounds of the polygon
+ */
+polygon_props_t polygon_properties(list_t *polygon);
+
+/**
+ * Computes the distance from a point to the farthest vertex of a polygon.
+ * When point is the centroid, this is the radius of the smallest circle
+ * around the centroid that contains the polygon.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @param point the center to measure from
+ * @return the largest distance from point to a vertex
+ */
+double polygon_radius(list_t *polygon, vector_t point);
+
+/**
+ * Computes the convex hull of a set of points.
+ * Duplicate points and points lying on a hull edge are dropped,
+ * so every remaining vertex is a strict corner.
+ * See https://en.wikibooks.org/wiki/Algorithm_Implementation/Geometry/Convex_hull/Monotone_chain.
+ *
+ * @param points the list of points; it is not modified
+ * @return a newly allocated list of the hull's vertices in counterclockwise
+ *   order, which must be list_free()d
+ */
+list_t *polygon_convex_hull(list_t *points);
+
+/**
+ * Reduces the number of vertices of a convex polygon.
+ * Repeatedly drops the vertex whose removal moves the outline least,
+ * as long as that is below the tolerance. A removal is measured against
+ * every original vertex the new edge would cover, not just the dropped one,
+ * so the outline never moves by more than the tolerance in total.
+ * Never reduces a polygon below 3 vertices.
+ * Note: mutates the original polygon.
+ *
+ * @param polygon the list of vertices, in counterclockwise order
+ * @param tolerance the largest allowed deviation from the original outline
+ */
+void polygon_simplify(list_t *polygon, double tolerance);
+
+/**
+ * Computes the axis-aligned bounding box of a polygon.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @return the smallest box containing every vertex
+ */
+aabb_t polygon_bounds(list_t *polygon);
+
+/**
+ * Returns whether two axis-aligned boxes overlap (touching counts).
+ *
+ * @param a the first box
+ * @param b the second box
+ * @return whether the boxes share at least one point
+ */
+bool aabb_overlap(aabb_t a, aabb_t b);
+
+/**
+ * Computes the smallest axis-aligned box containing two boxes.
+ *
+ * @param a the first box
+ * @param b the second box
+ * @return the box around both
+ */
+aabb_t aabb_union(aabb_t a, aabb_t b);
+
+/**
+ * Translates an axis-aligned box by a given vector.
+ *
+ * @param box the box to move
+ * @param translation the vector to add to both corners
+ * @return the translated box
+ */
+aabb_t aabb_translate(aabb_t box, vector_t translation);
+
 /**
  * Translates all vertices in a polygon by a given vector.
  * Note: mutates the original polygon.
@@ -0,0 +1,144 @@
+#ifndef __PROTOTYPE_H__
+#define __PROTOTYPE_H__
+
+#include "list.h"
+#include "polygon.h"
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * An immutable polygon stored in local space, i.e. with its centroid at the
+ * origin and no rotation applied.
+ * Many bodies can share one prototype, each with its own position and angle.
+ * Prototypes are reference counted: every function below that returns a
+ * prototype hands the caller one reference, which must eventually be given
+ * back with prototype_release() (or handed to a body, which releases it).
+ */
+typedef struct prototype prototype_t;
+
+/**
+ * Creates a prototype from an arbitrary polygon.
+ * The polygon is translated so its centroid lies at the origin.
+ * Such prototypes are not interned, so each call creates a new one.
+ *
+ * @param shape a list of vertices in counterclockwise order.
+ *   The prototype takes ownership of the list and frees it.
+ * @param centroid if non-NULL, set to the centroid of shape
+ *   before it was moved to the origin
+ * @return a new prototype with one reference
+ */
+prototype_t *prototype_init(list_t *shape, vector_t *centroid);
+
+/**
+ * Creates a prototype from the convex hull of a set of points.
+ * Duplicate and collinear points are removed, and vertices are dropped while
+ * the outline stays within the tolerance (see polygon_simplify()),
+ * so collision cost follows the real shape rather than how it was built.
+ *
+ * @param shape a list of points in any order.
+ *   The prototype takes ownership of the list and frees it.
+ * @param tolerance how far the simplified outline may deviate from the hull;
+ *   0 keeps every hull vertex
+ * @param centroid if non-NULL, set to the centroid of the hull
+ *   before it was moved to the origin
+ * @return a new prototype with one reference
+ */
+prototype_t *prototype_init_convex(list_t *shape, double tolerance,
+                                   vector_t *centroid);
+
+/**
+ * Gets the shared prototype of a rectangle centered at the origin.
+ * Rectangles with the same dimensions always return the same prototype.
+ *
+ * @param width the size of the rectangle along the x-axis
+ * @param height the size of the rectangle along the y-axis
+ * @return the interned prototype, with one new reference
+ */
+prototype_t *prototype_rect(double width, double height);
+
+/**
+ * Gets the shared prototype of an ellipse centered at the origin.
+ * Ellipses with the same axes and vertex count always return the same
+ * prototype, so the trigonometry in make_ellipse() runs only once.
+ * The prototype is the convex hull of make_ellipse()'s points,
+ * so it has no center vertex or repeated rim vertex.
+ *
+ * @param axisa the semi-axis along x
+ * @param axisb the semi-axis along y
+ * @param vertices the number of vertices along the rim
+ * @return the interned prototype, with one new reference
+ */
+prototype_t *prototype_ellipse(double axisa, double axisb, size_t vertices);
+
+/**
+ * Takes an additional reference to a prototype.
+ *
+ * @param proto the prototype to share
+ * @return proto, for convenience
+ */
+prototype_t *prototype_retain(prototype_t *proto);
+
+/**
+ * Gives back a reference to a prototype,
+ * freeing it once no references are left.
+ *
+ * @param proto the prototype to release
+ */
+void prototype_release(prototype_t *proto);
+
+/**
+ * Gets the number of vertices in a prototype.
+ *
+ * @param proto the prototype
+ * @return the number of vertices
+ */
+size_t prototype_size(prototype_t *proto);
+
+/**
+ * Gets a vertex of a prototype, relative to its centroid.
+ * Asserts that the index is valid.
+ *
+ * @param proto the prototype
+ * @param index the index of the vertex (starting at 0)
+ * @return the vertex in local space
+ */
+vector_t prototype_get_vertex(prototype_t *proto, size_t index);
+
+/**
+ * Gets a triangulation of a prototype, for drawing it as triangles.
+ * It is computed on first use and cached with the prototype, so every body
+ * sharing the prototype reuses it. Convex prototypes are fanned out from
+ * their first vertex; concave ones are split by ear clipping.
+ *
+ * @param proto the prototype
+ * @param count set to the number of indices, three per triangle
+ *   (0 if the prototype has fewer than three vertices)
+ * @return the vertex indices of each triangle, owned by the prototype
+ */
+const int *prototype_get_triangles(prototype_t *proto, size_t *count);
+
+/**
+ * Gets the area enclosed by a prototype.
+ *
+ * @param proto the prototype
+ * @return the area of the polygon
+ */
+double prototype_get_area(prototype_t *proto);
+
+/**
+ * Gets the distance from a prototype's centroid to its farthest vertex.
+ *
+ * @param proto the prototype
+ * @return the bounding radius
+ */
+double prototype_get_radius(prototype_t *proto);
+
+/**
+ * Gets the bounding box of a prototype in local space.
+ *
+ * @param proto the prototype
+ * @return the smallest axis-aligned box containing the unrotated prototype
+ */
+aabb_t prototype_get_bounds(prototype_t *proto);
+
+#endif // #ifndef __PROTOTYPE_H__
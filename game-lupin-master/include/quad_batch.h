@@ -0,0 +1,62 @@
+#ifndef __QUAD_BATCH_H__
+#define __QUAD_BATCH_H__
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+
+/**
+ * A growing buffer of textured quads that are drawn together with one
+ * SDL_RenderGeometry() call.
+ * Flushing empties the batch but keeps its memory, so a batch that is
+ * refilled every frame only allocates when it outgrows every earlier frame.
+ */
+typedef struct quad_batch quad_batch_t;
+
+/**
+ * Allocates memory for an empty batch.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new batch
+ */
+quad_batch_t *quad_batch_init(void);
+
+/**
+ * Releases the memory allocated for a batch.
+ *
+ * @param batch a pointer to a batch returned from quad_batch_init()
+ */
+void quad_batch_free(quad_batch_t *batch);
+
+/**
+ * Adds an axis-aligned quad to a batch.
+ *
+ * @param batch the batch
+ * @param dst where to draw the quad, in pixels
+ * @param src the part of the texture to draw, in pixels
+ * @param texture_width the width of the texture in pixels
+ * @param texture_height the height of the texture in pixels
+ * @param color the color to tint the quad with
+ */
+void quad_batch_add(quad_batch_t *batch, SDL_Rect dst, SDL_Rect src,
+                    int texture_width, int texture_height, SDL_Color color);
+
+/**
+ * Gets the number of quads waiting in a batch.
+ *
+ * @param batch the batch
+ * @return the number of quads added since the last flush
+ */
+size_t quad_batch_size(quad_batch_t *batch);
+
+/**
+ * Draws every quad in a batch with one SDL_RenderGeometry() call
+ * and empties the batch. Does nothing if the batch is empty.
+ *
+ * @param batch the batch
+ * @param renderer the renderer to draw with
+ * @param texture the texture all of the quads are cut from
+ */
+void quad_batch_flush(quad_batch_t *batch, SDL_Renderer *renderer,
+                      SDL_Texture *texture);
+
+#endif // #ifndef __QUAD_BATCH_H__
@@ -0,0 +1,82 @@
+#ifndef __QUERY_H__
+#define __QUERY_H__
+
+#include "body.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A body hit by a raycast or shape cast (see scene_raycast()).
+ */
+typedef struct {
+  /** The body that was hit */
+  body_t *body;
+  /** How far along the cast's translation the hit happened, from 0 to 1 */
+  double fraction;
+  /**
+   * For raycasts, the point where the ray meets the body.
+   * For shape casts, where the cast shape's centroid is when it touches.
+   */
+  vector_t point;
+  /**
+   * The unit normal of the hit body's surface, pointing back at the caster.
+   * Zero if the cast starts out already touching the body.
+   */
+  vector_t normal;
+} cast_hit_t;
+
+/**
+ * A function called for each body found by an overlap query
+ * (see scene_query_aabb()). Returns false to stop the query early.
+ */
+typedef bool (*query_callback_t)(body_t *body, void *aux);
+
+/**
+ * A function called for each hit found by a cast (see scene_raycast_all()).
+ * Returns false to stop the cast early.
+ */
+typedef bool (*cast_callback_t)(cast_hit_t hit, void *aux);
+
+/**
+ * Returns whether a body is selected by a query's category mask.
+ * A mask of UINT32_MAX selects every body, including those without a category
+ * (see body_set_collision_filter()).
+ *
+ * @param body the body
+ * @param mask the categories to select
+ * @return whether the body's category shares a bit with the mask
+ */
+bool query_matches(body_t *body, uint32_t mask);
+
+/**
+ * Sweeps a convex polygon along a translation and finds when it first
+ * touches a body's shape, by intersecting the time intervals in which the
+ * two overlap along each of their edge normals.
+ * A single point may be swept (a raycast), and a zero translation tests for
+ * overlap. Does not allocate.
+ *
+ * @param points the vertices of the swept polygon in counterclockwise order
+ * @param size the number of vertices
+ * @param translation how far the polygon moves over the sweep
+ * @param body the body to test against
+ * @param hit set to the fraction and normal of the impact, if there is one
+ * @return whether the polygon touches the body during the sweep
+ */
+bool query_cast_points(const vector_t *points, size_t size,
+                       vector_t translation, body_t *body, cast_hit_t *hit);
+
+/**
+ * Like query_cast_points(), but sweeps the current shape of a body.
+ *
+ * @param shape the body whose shape is swept
+ * @param translation how far the shape moves over the sweep
+ * @param body the body to test against
+ * @param hit set to the fraction and normal of the impact, if there is one
+ * @return whether the shape touches the body during the sweep
+ */
+bool query_cast_body(body_t *shape, vector_t translation, body_t *body,
+                     cast_hit_t *hit);
+
+#endif // #ifndef __QUERY_H__
@@ -0,0 +1,121 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#include "vector.h"
+#include <SDL2/SDL.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The draw commands recorded for one frame, so they can be submitted in an
+ * order that changes renderer state as little as possible.
+ * Every command gets a 64-bit sort key that packs, from the most
+ * significant bits down, its layer, blend mode, texture and the order it
+ * was pushed in. Sorting the keys groups commands by layer, then by blend
+ * mode, then by texture, and keeps commands that tie on all three in the
+ * order they were pushed.
+ * The queue keeps its memory between frames, so a frame only allocates when
+ * it records more commands than any earlier frame.
+ */
+typedef struct render_queue render_queue_t;
+
+/**
+ * Layers are drawn in order, so a later layer covers an earlier one.
+ */
+typedef enum {
+  RENDER_LAYER_BACKGROUND,
+  RENDER_LAYER_TEXT,
+  RENDER_LAYER_BODIES
+} render_layer_t;
+
+/**
+ * What a command draws, which tells how to read its item.
+ */
+typedef enum {
+  RENDER_STATIC_LAYER, // texture is the cached static layer; no item
+  RENDER_BACKGROUND,   // item is the scene's sprite_t
+  RENDER_SPRITE,       // item is a sprite_t, centered at pos
+  RENDER_POLYGON,      // item is an untextured body_t
+  RENDER_TEXT,         // item is a text_t with its own texture
+  RENDER_GLYPHS        // item is a dynamic text_t (see text_set_dynamic())
+} render_kind_t;
+
+typedef struct render_command {
+  render_kind_t kind;
+  SDL_Texture *texture;
+  void *item;
+  // The window position to draw at, for sprites
+  vector_t pos;
+} render_command_t;
+
+/**
+ * Allocates memory for an empty queue.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new queue
+ */
+render_queue_t *render_queue_init(void);
+
+/**
+ * Releases the memory allocated for a queue.
+ * The queue does not own the items of its commands.
+ *
+ * @param queue a pointer to a queue returned from render_queue_init()
+ */
+void render_queue_free(render_queue_t *queue);
+
+/**
+ * Removes every command from a queue, keeping its memory for the next frame.
+ *
+ * @param queue the queue
+ */
+void render_queue_clear(render_queue_t *queue);
+
+/**
+ * Records a draw command.
+ *
+ * @param queue the queue
+ * @param layer the layer to draw the command in
+ * @param blend how the command blends with what is under it
+ * @param command what to draw
+ */
+void render_queue_push(render_queue_t *queue, render_layer_t layer,
+                       SDL_BlendMode blend, render_command_t command);
+
+/**
+ * Sorts the commands of a queue by their keys, with an LSD radix sort
+ * that skips the bytes every key shares.
+ *
+ * @param queue the queue
+ */
+void render_queue_sort(render_queue_t *queue);
+
+/**
+ * Gets the number of commands in a queue.
+ *
+ * @param queue the queue
+ * @return the number of commands pushed since the queue was last cleared
+ */
+size_t render_queue_size(render_queue_t *queue);
+
+/**
+ * Gets a command by its position in the queue:
+ * the order it was pushed in, or its sorted position after
+ * render_queue_sort().
+ *
+ * @param queue the queue
+ * @param index the position of the command
+ * @return a pointer to the command, which the queue owns
+ */
+render_command_t *render_queue_get(render_queue_t *queue, size_t index);
+
+/**
+ * Gets the number of distinct textures among a queue's commands,
+ * not counting untextured commands.
+ *
+ * @param queue the queue
+ * @return the number of textures
+ */
+size_t render_queue_textures(render_queue_t *queue);
+
+#endif // #ifndef __RENDER_QUEUE_H__
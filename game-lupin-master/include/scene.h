@@ -2,7 +2,11 @@
 #define __SCENE_H__
 
 #include "body.h"
+#include "broadphase.h"
+#include "integrator.h"
 #include "list.h"
+#include "query.h"
+#include "solver.h"
 #include "text.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -10,6 +14,7 @@
 #include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_ttf.h>
+#include <stdint.h>
 
 /**
  * A collection of bodies and force creators.
@@ -18,6 +23,11 @@
  */
 typedef struct scene scene_t;
 
+/**
+ * How a scene advances time; see scene_set_mode().
+ */
+typedef enum { SCENE_MODE_STEPPED, SCENE_MODE_EVENT_DRIVEN } scene_mode_t;
+
 /**
  * A function which adds some forces or impulses to bodies,
  * e.g. from collisions, gravity, or spring forces.
@@ -113,12 +123,320 @@ void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer);
 
+/**
+ * Gets the contact solver of a scene.
+ * Physics collisions add their touching contacts to it every tick.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's solver
+ */
+solver_t *scene_get_solver(scene_t *scene);
+
+/**
+ * Makes touching bodies in two categories collide physically, like
+ * create_physics_collision() does, without registering every pair.
+ * Applies to bodies added before or after the rule.
+ * See body_set_collision_filter() and broadphase_add_rule().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param category1 the categories of the first body of a pair
+ * @param category2 the categories of the second body of a pair
+ * @param elasticity the coefficient of restitution of the collisions
+ */
+void scene_add_collision_rule(scene_t *scene, uint32_t category1,
+                              uint32_t category2, double elasticity);
+
+/**
+ * Calls a handler when bodies in two categories start touching, like
+ * create_collision() does, without registering every pair.
+ * The handler receives the body in category1 first.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param category1 the categories of the first body of a pair
+ * @param category2 the categories of the second body of a pair
+ * @param handler a function to call whenever a pair starts touching
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_collision_handler_rule(scene_t *scene, uint32_t category1,
+                                      uint32_t category2,
+                                      collision_handler_t handler, void *aux,
+                                      free_func_t freer);
+
+/**
+ * Gets the broad phase that pairs up bodies for the collision rules.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's broad phase
+ */
+broadphase_t *scene_get_broadphase(scene_t *scene);
+
+/**
+ * Gets the number of trigger events reported by sensors
+ * during the last scene_tick().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of events
+ */
+size_t scene_trigger_events(scene_t *scene);
+
+/**
+ * Gets a trigger event reported during the last scene_tick().
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index of the event (starting at 0)
+ * @return the sensor, the body that entered or left it,
+ *   and whether it entered
+ */
+trigger_event_t scene_get_trigger_event(scene_t *scene, size_t index);
+
+/**
+ * Gets the length of the tick being run, or of the last one.
+ * Lets force creators that integrate implicitly (see spring_network.h)
+ * know the step they are solving for.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the dt passed to scene_tick(), in seconds
+ */
+double scene_get_dt(scene_t *scene);
+
+/**
+ * Chooses how the scene advances its bodies each tick.
+ * More accurate schemes evaluate field forces more often per tick, so they
+ * cost more per tick but stay accurate with larger ticks.
+ * Scenes start with INTEGRATOR_AVERAGE (body_tick()).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param integrator the scheme to use from the next tick on
+ */
+void scene_set_integrator(scene_t *scene, integrator_t integrator);
+
+/**
+ * Gets how the scene advances its bodies each tick.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scheme set with scene_set_integrator()
+ */
+integrator_t scene_get_integrator(scene_t *scene);
+
+/**
+ * Gets how many substeps the last scene_tick() was split into.
+ * Useful for tuning: a scene at rest runs one substep per tick,
+ * and fast pellets run just enough not to skip through thin bodies.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of substeps, or 0 before the first tick and after
+ *   event-driven ticks (see scene_set_mode())
+ */
+size_t scene_get_last_substeps(scene_t *scene);
+
+/**
+ * Gets the number of contact islands found by the last scene_tick().
+ * Bodies at rest are put to sleep an island at a time; see islands_update().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of islands
+ */
+size_t scene_islands(scene_t *scene);
+
+/**
+ * Chooses how the scene advances time.
+ * SCENE_MODE_EVENT_DRIVEN predicts when each interacting pair will touch and
+ * jumps straight from one impact to the next (see toi.h), which is exact for
+ * fast pellets and costs nothing while no impact is due. It only applies
+ * while the scene is ballistic: no force creators, no drag, acceleration
+ * or spin on any body, and no body colliding with its pixels
+ * (see body_set_pixel_collision()). Other ticks fall back to fixed substeps.
+ * Scenes start in SCENE_MODE_STEPPED.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param mode the mode to use from the next tick on
+ */
+void scene_set_mode(scene_t *scene, scene_mode_t mode);
+
+/**
+ * Gets how the scene advances time.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the mode set with scene_set_mode()
+ */
+scene_mode_t scene_get_mode(scene_t *scene);
+
+/**
+ * Gets how many impacts the last event-driven scene_tick() resolved.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of impacts
+ */
+size_t scene_get_last_impacts(scene_t *scene);
+
+/**
+ * Sorts the scene's bodies along a Z-order (Morton) curve of their
+ * positions (see body_pool_sort()). The state the physics loops touch
+ * lives in the scene's body pool, which is permuted in memory, and the
+ * bodies list is reordered to match, so the force, integration and narrow
+ * phase loops walk neighbouring bodies through neighbouring memory.
+ * Indices from scene_get_body() change, and so does the order bodies are
+ * drawn in; body pointers stay valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_reorder_bodies(scene_t *scene);
+
+/**
+ * Makes scene_tick() call scene_reorder_bodies() every few ticks.
+ * Off by default; worthwhile in large scenes whose bodies drift apart.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param ticks the number of ticks between reorders, or 0 to never reorder
+ */
+void scene_set_reorder_interval(scene_t *scene, size_t ticks);
+
+/**
+ * Calls a function for every body overlapping a box.
+ * Bodies are found through the broad phase (see broadphase_query()) with
+ * their bounding boxes from the last tick, then tested against their exact
+ * shapes. Does not allocate.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param box the box to search
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param callback called for each body, in no particular order,
+ *   until it returns false
+ * @param aux an auxiliary value to pass to the callback
+ * @return the number of bodies passed to the callback
+ */
+size_t scene_query_aabb(scene_t *scene, aabb_t box, uint32_t mask,
+                        query_callback_t callback, void *aux);
+
+/**
+ * Like scene_query_aabb(), but stores the bodies in a caller's buffer.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param box the box to search
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param bodies the buffer, filled in no particular order
+ * @param capacity the size of the buffer; the query stops once it is full
+ * @return the number of bodies stored
+ */
+size_t scene_query_aabb_buffer(scene_t *scene, aabb_t box, uint32_t mask,
+                               body_t **bodies, size_t capacity);
+
+/**
+ * Calls a function for every body containing a point. Does not allocate.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param point the point
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param callback called for each body until it returns false
+ * @param aux an auxiliary value to pass to the callback
+ * @return the number of bodies passed to the callback
+ */
+size_t scene_query_point(scene_t *scene, vector_t point, uint32_t mask,
+                         query_callback_t callback, void *aux);
+
+/**
+ * Like scene_query_point(), but stores the bodies in a caller's buffer.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param point the point
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param bodies the buffer
+ * @param capacity the size of the buffer; the query stops once it is full
+ * @return the number of bodies stored
+ */
+size_t scene_query_point_buffer(scene_t *scene, vector_t point, uint32_t mask,
+                                body_t **bodies, size_t capacity);
+
+/**
+ * Finds the first body along a ray. Does not allocate.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param origin where the ray starts
+ * @param translation the ray's direction and length
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param hit set to the closest hit, if there is one
+ * @return whether the ray hits any body
+ */
+bool scene_raycast(scene_t *scene, vector_t origin, vector_t translation,
+                   uint32_t mask, cast_hit_t *hit);
+
+/**
+ * Calls a function for every body along a ray. Does not allocate.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param origin where the ray starts
+ * @param translation the ray's direction and length
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param callback called for each hit, in no particular order,
+ *   until it returns false
+ * @param aux an auxiliary value to pass to the callback
+ * @return the number of hits passed to the callback
+ */
+size_t scene_raycast_all(scene_t *scene, vector_t origin, vector_t translation,
+                         uint32_t mask, cast_callback_t callback, void *aux);
+
+/**
+ * Like scene_raycast_all(), but stores the hits in a caller's buffer.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param origin where the ray starts
+ * @param translation the ray's direction and length
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param hits the buffer, filled in no particular order
+ * @param capacity the size of the buffer; the cast stops once it is full
+ * @return the number of hits stored
+ */
+size_t scene_raycast_buffer(scene_t *scene, vector_t origin,
+                            vector_t translation, uint32_t mask,
+                            cast_hit_t *hits, size_t capacity);
+
+/**
+ * Finds the first body a body's shape would touch if it moved along a
+ * translation. The body itself is never hit. Does not allocate.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param shape the body whose current shape is swept
+ * @param translation how far the shape moves
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param hit set to the closest hit, if there is one
+ * @return whether the shape hits any body
+ */
+bool scene_shape_cast(scene_t *scene, body_t *shape, vector_t translation,
+                      uint32_t mask, cast_hit_t *hit);
+
+/**
+ * Calls a function for every body a body's shape would touch if it moved
+ * along a translation. Does not allocate.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param shape the body whose current shape is swept
+ * @param translation how far the shape moves
+ * @param mask the categories of bodies to find (see query_matches())
+ * @param callback called for each hit until it returns false
+ * @param aux an auxiliary value to pass to the callback
+ * @return the number of hits passed to the callback
+ */
+size_t scene_shape_cast_all(scene_t *scene, body_t *shape,
+                            vector_t translation, uint32_t mask,
+                            cast_callback_t callback, void *aux);
+
 /**
  * Executes a tick of a given scene over a small time interval.
- * This requires executing all the force creators
- * and then ticking each body (see body_tick()).
+ * The tick is split into equal substeps so that no awake body moves more
+ * than half its thickness per substep, up to a limit of 8
+ * (see scene_get_last_substeps()).
+ * Each substep executes all the force creators,
+ * runs the broad phase for the collision rules (see broadphase_update()),
+ * resolves the contacts they found (see solver_solve()),
+ * advances each body with the scene's integrator (see integration_step())
+ * and then puts resting islands to sleep (see islands_update()).
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
+ * Trigger events from every substep are kept until the next tick.
+ * In SCENE_MODE_EVENT_DRIVEN, ballistic scenes advance impact by impact
+ * instead (see scene_set_mode()).
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
@@ -4,9 +4,14 @@
 #include "color.h"
 #include "game.h"
 #include "game_info.h"
+#include "glyph_atlas.h"
 #include "list.h"
+#include "mask.h"
+#include "render_queue.h"
 #include "scene.h"
+#include "sprite.h"
 #include "state.h"
+#include "text.h"
 #include "vector.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -25,15 +30,78 @@ typedef enum {
   SPACE_BAR = 5
 } arrow_key_t;
 
+/**
+ * Where frames are drawn.
+ */
+typedef enum {
+  // A resizable window with a vsync renderer, as on desktop and the web
+  RENDER_BACKEND_WINDOW,
+  // A software renderer drawing into an in-memory surface, with no window
+  // (see sdl_get_frame_surface())
+  RENDER_BACKEND_SOFTWARE,
+  // Frames are recorded and counted (see sdl_get_render_stats()) but never
+  // drawn; textures are still loaded so sprites keep their real sizes
+  RENDER_BACKEND_NULL
+} render_backend_t;
+
+/**
+ * Counters for the frames rendered since the program started
+ * or since sdl_reset_render_stats().
+ */
+typedef struct render_stats {
+  size_t frames;
+  // Draw commands recorded, whether or not the backend drew them
+  size_t commands;
+  // Distinct textures drawn from, summed over frames
+  size_t textures;
+  // Times the cached static layer was redrawn
+  size_t static_layer_draws;
+  // Processor time spent in sdl_render_scene()
+  double seconds;
+} render_stats_t;
+
 /**
  * Initializes the SDL window and renderer.
  * Must be called once before any of the other SDL functions.
+ * Same as sdl_init_backend() with RENDER_BACKEND_WINDOW.
  *
  * @param min the x and y coordinates of the bottom left of the scene
  * @param max the x and y coordinates of the top right of the scene
  */
 void sdl_init(vector_t min, vector_t max);
 
+/**
+ * Initializes SDL to draw with the given backend.
+ * Must be called once, instead of sdl_init(), before any of the other SDL
+ * functions. The headless backends need no display, so the game loop can
+ * run in CI or on a server; frames are WINDOW_WIDTH x WINDOW_HEIGHT.
+ *
+ * @param min the x and y coordinates of the bottom left of the scene
+ * @param max the x and y coordinates of the top right of the scene
+ * @param backend where to draw frames
+ */
+void sdl_init_backend(vector_t min, vector_t max, render_backend_t backend);
+
+/**
+ * Gets the pixels of the last frame drawn by the software backend.
+ *
+ * @return the surface frames are drawn into, owned by SDL,
+ *   or NULL for the other backends
+ */
+SDL_Surface *sdl_get_frame_surface(void);
+
+/**
+ * Gets the rendering counters, e.g. to benchmark a headless run.
+ *
+ * @return the counters
+ */
+render_stats_t sdl_get_render_stats(void);
+
+/**
+ * Zeroes the rendering counters.
+ */
+void sdl_reset_render_stats(void);
+
 /**
  * Processes all SDL events and returns whether the window has been closed.
  * This function must be called in order to handle keypresses.
@@ -49,20 +117,150 @@ void sdl_clear(void);
 
 /**
  * Draws a polygon from the given list of vertices and a color.
+ * The polygon is fanned out into triangles from its first vertex, so it
+ * must be convex, like the shapes the physics engine collides.
  *
  * @param points the list of vertices of the polygon
  * @param color the color used to fill in the polygon
  */
 void sdl_draw_polygon(list_t *points, rgb_color_t color);
 
+/**
+ * Draws an untextured body as a polygon of its color right away.
+ * Unlike sdl_draw_polygon(body_get_shape(body), ...) it allocates nothing,
+ * and concave bodies are drawn correctly.
+ *
+ * @param body the body to draw
+ */
+void sdl_draw_body(body_t *body);
+
+/**
+ * Queues an untextured body to be drawn as triangles of its color,
+ * using the triangulation cached with its prototype
+ * (see prototype_get_triangles()).
+ * Every queued body is drawn together with one SDL_RenderGeometry() call
+ * by sdl_flush_polygons(), whatever its color.
+ *
+ * @param body the body to draw
+ */
+void sdl_queue_body(body_t *body);
+
+/**
+ * Draws the bodies queued by sdl_queue_body().
+ */
+void sdl_flush_polygons(void);
+
+/**
+ * Makes the next draw recompute the mapping from scene to window
+ * coordinates. Resizes seen by sdl_is_done() do this automatically.
+ */
+void sdl_invalidate_view(void);
+
 /**
  * Displays the rendered frame on the SDL window.
  * Must be called after drawing the polygons in order to show them.
  */
 void sdl_show(void);
 
+/**
+ * Makes the next sdl_render_scene() redraw the cached static layer,
+ * e.g. after changing the color of a static body.
+ */
+void sdl_invalidate_static_layer(void);
+
+/**
+ * Draws a sprite centered at a window position right away.
+ *
+ * @param sprite the sprite to draw
+ * @param pos the center of the sprite in pixels
+ */
+void sdl_draw_sprite(sprite_t *sprite, vector_t pos);
+
+/**
+ * Adds a sprite centered at a window position to the sprite batch.
+ * Consecutive sprites cut from the same texture, such as one atlas page
+ * (see texture_cache_pack()), are drawn together with one
+ * SDL_RenderGeometry() call; queueing a sprite from another texture first
+ * draws the batch.
+ *
+ * @param sprite the sprite to draw
+ * @param pos the center of the sprite in pixels
+ */
+void sdl_queue_sprite(sprite_t *sprite, vector_t pos);
+
+/**
+ * Draws the sprites queued by sdl_queue_sprite().
+ */
+void sdl_flush_sprites(void);
+
+/**
+ * Gets FONT_FILE opened at a size, opening it on first use.
+ * Fonts stay open for the rest of the program.
+ *
+ * @param size the font size
+ * @return the shared font
+ */
+TTF_Font *sdl_get_font(int size);
+
+/**
+ * Draws a text on top of the frame.
+ * The text is rasterised only when its content has changed since it was
+ * last drawn (see text_update_content()); otherwise this is one copy of the
+ * text's cached texture.
+ *
+ * @param text the text to draw
+ */
+void sdl_draw_text(text_t *text);
+
+/**
+ * Gets the glyph atlas of FONT_FILE at a size, building it on first use.
+ *
+ * @param size the font size
+ * @return the shared atlas
+ */
+glyph_atlas_t *sdl_get_glyph_atlas(int size);
+
+/**
+ * Lays out a text from its font's glyph atlas and adds it to the atlas's
+ * batch. Nothing is drawn until sdl_flush_text().
+ *
+ * @param text the text to draw
+ */
+void sdl_queue_text(text_t *text);
+
+/**
+ * Draws the texts queued by sdl_queue_text(),
+ * with one SDL_RenderGeometry() call per font size.
+ */
+void sdl_flush_text(void);
+
+/**
+ * Records the draw commands for a scene's background, texts and bodies.
+ *
+ * @param queue the queue to record into
+ * @param scene the scene to draw
+ * @param include_static whether to draw the background and static bodies
+ *   themselves; if false, the cached static layer is drawn in their place
+ */
+void sdl_record_scene(render_queue_t *queue, scene_t *scene,
+                      bool include_static);
+
+/**
+ * Carries out the commands of a queue in their current order,
+ * batching runs of sprites and of dynamic texts.
+ *
+ * @param queue the queue, usually sorted with render_queue_sort()
+ */
+void sdl_submit(render_queue_t *queue);
+
 /**
  * Draws all bodies in a scene.
+ * The background, the bodies marked with body_set_static() and the boundary
+ * are drawn into a cached render target, which is only redrawn when one of
+ * them moves or the window is resized, and copied to the window each frame.
+ * The rest of the scene is recorded into a render queue (see render_queue.h), which is
+ * sorted so that draws sharing a texture and blend mode run back to back
+ * before being submitted.
  * This internally calls sdl_clear(), sdl_draw_polygon(), and sdl_show(),
  * so those functions should not be called directly.
  *
@@ -118,6 +316,41 @@ double time_since_last_tick(void);
 
 SDL_Texture *sdl_create_texture(const char *f);
 
+/**
+ * Decodes an image into a surface with SDL_PIXELFORMAT_RGBA32 pixels.
+ *
+ * @param f the image file
+ * @return the new surface, which the caller must free
+ */
+SDL_Surface *sdl_load_rgba_surface(const char *f);
+
+/**
+ * Uploads an image that is already in memory into a texture.
+ *
+ * @param surface the image
+ * @return the new texture
+ */
+SDL_Texture *sdl_create_texture_from_surface(SDL_Surface *surface);
+
+/**
+ * Loads an image into a texture along with the collision mask of its opaque
+ * pixels (see mask.h), reading the image only once.
+ *
+ * @param f the image file
+ * @param mask set to the new mask, which the caller must free
+ * @return the new texture
+ */
+SDL_Texture *sdl_create_texture_with_mask(const char *f, mask_t **mask);
+
+/**
+ * Builds the collision mask of an image's opaque pixels without creating a
+ * texture, for images that are already loaded without one.
+ *
+ * @param f the image file
+ * @return the new mask, which the caller must free
+ */
+mask_t *sdl_create_mask(const char *f);
+
 void sdl_free_noise(Mix_Chunk *noise);
 
 SDL_Texture *sdl_create_pic(char *f, vector_t pos, double scaling);
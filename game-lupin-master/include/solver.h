@@ -0,0 +1,158 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include "body.h"
+#include "collision.h"
+#include <stdbool.h>
+
+/**
+ * The persistent contact state between two bodies.
+ * Lives as long as the pair is being checked for collisions, so the impulse
+ * accumulated in one tick can warm-start the solver in the next one,
+ * and the last separating axis can speed up the next narrow phase.
+ */
+typedef struct contact contact_t;
+
+/**
+ * An iterative sequential-impulse contact solver.
+ * Each tick, touching contacts are added to the solver, which then resolves
+ * them all together so simultaneous contacts (e.g. a pellet pinched between
+ * a paddle and a wall) settle in a single tick.
+ */
+typedef struct solver solver_t;
+
+/**
+ * Allocates memory for the contact state of a pair of bodies.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param elasticity the "coefficient of restitution" of the contact;
+ * 0 is a perfectly inelastic collision and 1 is a perfectly elastic collision
+ * @return the new contact, initially not touching
+ */
+contact_t *contact_init(body_t *body1, body_t *body2, double elasticity);
+
+/**
+ * Releases the memory allocated for a contact.
+ * Does not free its bodies.
+ *
+ * @param contact a pointer to a contact returned from contact_init()
+ */
+void contact_free(contact_t *contact);
+
+/**
+ * Runs the narrow phase for a contact's bodies and stores the result.
+ * The accumulated impulse is kept if the bodies were already touching
+ * and discarded if they have separated.
+ *
+ * @param contact a pointer to a contact returned from contact_init()
+ * @return whether the bodies are currently colliding
+ */
+bool contact_update(contact_t *contact);
+
+/**
+ * Gets the first body of a contact.
+ *
+ * @param contact a pointer to a contact returned from contact_init()
+ * @return the body1 passed to contact_init()
+ */
+body_t *contact_get_body1(contact_t *contact);
+
+/**
+ * Gets the second body of a contact.
+ *
+ * @param contact a pointer to a contact returned from contact_init()
+ * @return the body2 passed to contact_init()
+ */
+body_t *contact_get_body2(contact_t *contact);
+
+/**
+ * Returns whether the last contact_update() found the bodies colliding.
+ *
+ * @param contact a pointer to a contact returned from contact_init()
+ * @return whether the bodies are touching
+ */
+bool contact_is_touching(contact_t *contact);
+
+/**
+ * Gets the collision found by the last contact_update().
+ *
+ * @param contact a pointer to a contact returned from contact_init()
+ * @return the axis (from body1 towards body2) and depth of the collision
+ */
+collision_info_t contact_get_info(contact_t *contact);
+
+/**
+ * Gets the normal impulse the solver accumulated on a contact last tick.
+ *
+ * @param contact a pointer to a contact returned from contact_init()
+ * @return the magnitude of the impulse pushing the bodies apart
+ */
+double contact_get_impulse(contact_t *contact);
+
+/**
+ * Allocates memory for an empty solver.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new solver
+ */
+solver_t *solver_init(void);
+
+/**
+ * Releases the memory allocated for a solver.
+ * Does not free the contacts added to it.
+ *
+ * @param solver a pointer to a solver returned from solver_init()
+ */
+void solver_free(solver_t *solver);
+
+/**
+ * Removes all pending contacts. Called at the start of every tick.
+ *
+ * @param solver a pointer to a solver returned from solver_init()
+ */
+void solver_clear(solver_t *solver);
+
+/**
+ * Adds a touching contact to be resolved on the next solver_solve().
+ * The solver does not own the contact.
+ *
+ * @param solver a pointer to a solver returned from solver_init()
+ * @param contact a contact whose bodies are colliding
+ */
+void solver_add_contact(solver_t *solver, contact_t *contact);
+
+/**
+ * Gets the number of contacts added since the last solver_clear().
+ *
+ * @param solver a pointer to a solver returned from solver_init()
+ * @return the number of pending contacts
+ */
+size_t solver_contacts(solver_t *solver);
+
+/**
+ * Gets a contact added since the last solver_clear().
+ * Asserts that the index is valid.
+ *
+ * @param solver a pointer to a solver returned from solver_init()
+ * @param index the index of the contact (starting at 0)
+ * @return the contact
+ */
+contact_t *solver_get_contact(solver_t *solver, size_t index);
+
+/**
+ * Resolves all pending contacts with sequential impulses.
+ * Each contact is first warm-started with the impulse it accumulated last
+ * tick; then a few passes apply corrective impulses (via body_add_impulse())
+ * until no pair is approaching, with restitution taken from the approach
+ * velocity at the start of the tick. Finally, overlapping bodies are pushed
+ * apart in proportion to their inverse masses.
+ * The contacts stay pending until solver_clear().
+ *
+ * @param solver a pointer to a solver returned from solver_init()
+ * @param dt the length of the tick, used to include this tick's forces
+ */
+void solver_solve(solver_t *solver, double dt);
+
+#endif // #ifndef __SOLVER_H__
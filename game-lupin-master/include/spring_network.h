@@ -0,0 +1,70 @@
+#ifndef __SPRING_NETWORK_H__
+#define __SPRING_NETWORK_H__
+
+#include "body.h"
+#include "scene.h"
+#include <stddef.h>
+
+/**
+ * A set of springs integrated together with implicit (backward) Euler,
+ * so stiff springs stay stable at normal tick rates.
+ * Each tick, the network solves
+ *   (M + dt^2 K) dv = dt (f - dt K v)
+ * for the velocity change dv of every body, where M holds the masses, f the
+ * spring forces and K the stiffness matrix of the springs linearized about
+ * the current positions. Each spring contributes a 2x2 block
+ *   k (n n^T + max(1 - rest_length / length, 0) (I - n n^T))
+ * along its direction n, whose second (transverse) term couples the x and y
+ * components; K is stored in block compressed sparse row (CSR) form, with
+ * the diagonal blocks kept separately.
+ * The x and y components of dv are solved together in one
+ * conjugate-gradient solve of a few iterations, starting from last tick's
+ * solution. Bodies with infinite mass are fixed anchors.
+ * The resulting velocity change is applied with body_add_impulse().
+ */
+typedef struct spring_network spring_network_t;
+
+/**
+ * Adds an empty spring network to a scene as a force creator.
+ * The scene owns the network: it is freed with the scene, or as soon as
+ * any of its bodies is removed, like other force creators.
+ *
+ * @param scene the scene containing the bodies
+ * @return the new network, to add springs to
+ */
+spring_network_t *create_spring_network(scene_t *scene);
+
+/**
+ * Adds a spring between two bodies.
+ * The spring pulls with force k * (distance - rest_length) along the line
+ * between the centroids; with a rest length of 0 this is the same force as
+ * create_spring(). The force is linearized about the current positions
+ * each tick, which keeps the system linear.
+ *
+ * @param network a network returned from create_spring_network()
+ * @param k the spring constant
+ * @param rest_length the distance at which the spring exerts no force
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+void spring_network_add_spring(spring_network_t *network, double k,
+                               double rest_length, body_t *body1,
+                               body_t *body2);
+
+/**
+ * Gets the number of springs in a network.
+ *
+ * @param network a network returned from create_spring_network()
+ * @return the number of springs
+ */
+size_t spring_network_springs(spring_network_t *network);
+
+/**
+ * Gets the number of bodies connected by a network's springs.
+ *
+ * @param network a network returned from create_spring_network()
+ * @return the number of bodies
+ */
+size_t spring_network_bodies(spring_network_t *network);
+
+#endif // #ifndef __SPRING_NETWORK_H__
@@ -1,6 +1,7 @@
 #ifndef __SPRITE_H__
 #define __SPRITE_H__
 
+#include "mask.h"
 #include <SDL2/SDL_image.h>
 
 typedef struct sprite sprite_t;
@@ -11,13 +12,64 @@ void sprite_free(sprite_t *sprite);
 
 SDL_Texture *sprite_get_texture(sprite_t *sprite);
 
+/**
+ * Shows a texture on a sprite, giving back the sprite's previous texture.
+ * The sprite takes over the caller's reference to the texture: cached
+ * textures (see texture_cache.h) are released when the sprite is done with
+ * them, and any other texture is destroyed.
+ * The sprite's mask is cleared and its region becomes the whole texture.
+ *
+ * @param sprite the sprite
+ * @param texture the texture to show
+ */
 void sprite_set_texture(sprite_t *sprite, SDL_Texture *texture);
 
 void sprite_set_texture_scaled(sprite_t *sprite, SDL_Texture *texture,
                                double scaling);
 
+/**
+ * Shows an image file on a sprite, loading it through the texture cache.
+ *
+ * @param sprite the sprite
+ * @param file the image file
+ */
 void sprite_load_texture(sprite_t *sprite, char *file);
 
+/**
+ * Gets the part of a sprite's texture that the sprite shows.
+ *
+ * @param sprite the sprite
+ * @return the region in texture pixels
+ */
+SDL_Rect sprite_get_region(sprite_t *sprite);
+
+/**
+ * Chooses the part of a sprite's texture to show,
+ * e.g. where the sprite's image was packed into an atlas page.
+ *
+ * @param sprite the sprite
+ * @param region the region in texture pixels
+ */
+void sprite_set_region(sprite_t *sprite, SDL_Rect region);
+
+/**
+ * Gives a sprite the collision mask of its texture.
+ * The mask must outlive the texture, as cached masks do (see
+ * texture_cache_acquire_with_mask()); the sprite does not free it.
+ *
+ * @param sprite the sprite
+ * @param mask the mask, or NULL for none
+ */
+void sprite_set_mask(sprite_t *sprite, mask_t *mask);
+
+/**
+ * Gets the collision mask of a sprite's texture.
+ *
+ * @param sprite the sprite
+ * @return the mask, or NULL if the texture was loaded without one
+ */
+mask_t *sprite_get_mask(sprite_t *sprite);
+
 bool sprite_has_texture(sprite_t *sprite);
 
 void sprite_set_scaling(sprite_t *sprite, double scaling);
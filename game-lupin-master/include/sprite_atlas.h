@@ -0,0 +1,80 @@
+#ifndef __SPRITE_ATLAS_H__
+#define __SPRITE_ATLAS_H__
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Square texture pages that many small images are packed into, so sprites
+ * cut from the same page can be drawn together without switching textures.
+ * Images are placed on shelves: rows filled left to right, each as tall as
+ * its tallest image. Adding images tallest first keeps the shelves tight.
+ * Images are copied into in-memory pages by sprite_atlas_add();
+ * sprite_atlas_upload() then turns every page into a texture.
+ */
+typedef struct sprite_atlas sprite_atlas_t;
+
+/**
+ * Allocates memory for an atlas with no pages.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @param page_size the width and height of each page in pixels
+ * @return the new atlas
+ */
+sprite_atlas_t *sprite_atlas_init(int page_size);
+
+/**
+ * Releases the memory allocated for an atlas, including its page textures.
+ *
+ * @param atlas a pointer to an atlas returned from sprite_atlas_init()
+ */
+void sprite_atlas_free(sprite_atlas_t *atlas);
+
+/**
+ * Copies an image into the first page with room for it,
+ * starting a new page if none has room.
+ * Must be called before sprite_atlas_upload().
+ *
+ * @param atlas the atlas
+ * @param image an image with SDL_PIXELFORMAT_RGBA32 pixels
+ * @param page set to the index of the page the image was put on
+ * @param region set to where on the page the image was put
+ * @return whether the image fit; images larger than a page are not added
+ */
+bool sprite_atlas_add(sprite_atlas_t *atlas, SDL_Surface *image, size_t *page,
+                      SDL_Rect *region);
+
+/**
+ * Creates the texture of every page and frees the pages' pixels.
+ *
+ * @param atlas the atlas
+ */
+void sprite_atlas_upload(sprite_atlas_t *atlas);
+
+/**
+ * Gets the number of pages in an atlas.
+ *
+ * @param atlas the atlas
+ * @return the number of pages
+ */
+size_t sprite_atlas_pages(sprite_atlas_t *atlas);
+
+/**
+ * Gets the texture of a page. Asserts that the atlas has been uploaded.
+ *
+ * @param atlas the atlas
+ * @param page the index of the page
+ * @return the page's texture, which belongs to the atlas
+ */
+SDL_Texture *sprite_atlas_get_texture(sprite_atlas_t *atlas, size_t page);
+
+/**
+ * Gets the size of each page of an atlas.
+ *
+ * @param atlas the atlas
+ * @return the width and height of a page in pixels
+ */
+int sprite_atlas_page_size(sprite_atlas_t *atlas);
+
+#endif // #ifndef __SPRITE_ATLAS_H__
@@ -3,11 +3,26 @@
 
 #include "vector.h"
 #include <SDL2/SDL.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+/**
+ * A string drawn on top of a scene.
+ * A text keeps the texture it was last drawn with (see sdl_draw_text()),
+ * so an unchanged text is only rasterised once.
+ */
 typedef struct text text_t;
 
+/**
+ * Allocates memory for a text.
+ *
+ * @param content the string to show; the text keeps its own copy
+ * @param pos the top left corner of the text
+ * @param color the color of the text
+ * @param size the font size
+ * @return the new text
+ */
 text_t *text_init_with_color(char *content, vector_t pos, SDL_Color color,
                              int size);
 
@@ -17,6 +32,13 @@ void text_free(text_t *text);
 
 char *text_get_content(text_t *text);
 
+/**
+ * Changes the string a text shows.
+ * The text's cached texture is dropped only if the string is different.
+ *
+ * @param text the text
+ * @param content the new string; the text keeps its own copy
+ */
 void text_update_content(text_t *text, char *content);
 
 vector_t text_get_pos(text_t *text);
@@ -25,4 +47,58 @@ SDL_Color text_get_color(text_t *text);
 
 int text_get_size(text_t *text);
 
+/**
+ * Returns whether a text is drawn from its font's glyph atlas
+ * (see glyph_atlas.h) instead of being rasterised whenever it changes.
+ *
+ * @param text the text
+ * @return whether the text is dynamic
+ */
+bool text_is_dynamic(text_t *text);
+
+/**
+ * Chooses how a text is drawn. Texts that change often, like scores,
+ * should be dynamic; texts are static by default.
+ *
+ * @param text the text
+ * @param dynamic whether to draw the text from its font's glyph atlas
+ */
+void text_set_dynamic(text_t *text, bool dynamic);
+
+/**
+ * Gets the texture a text was last rendered to.
+ *
+ * @param text the text
+ * @return the texture, or NULL if the text has changed since it was rendered
+ */
+SDL_Texture *text_get_texture(text_t *text);
+
+/**
+ * Gets the width of a text's cached texture.
+ *
+ * @param text the text
+ * @return the width in pixels
+ */
+int text_get_width(text_t *text);
+
+/**
+ * Gets the height of a text's cached texture.
+ *
+ * @param text the text
+ * @return the height in pixels
+ */
+int text_get_height(text_t *text);
+
+/**
+ * Caches the rendering of a text's current content.
+ * The text destroys the texture when it changes or is freed.
+ *
+ * @param text the text
+ * @param texture the rendered texture, or NULL to drop the cached one
+ * @param width the width of the texture in pixels
+ * @param height the height of the texture in pixels
+ */
+void text_set_texture(text_t *text, SDL_Texture *texture, int width,
+                      int height);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef __TEXTURE_CACHE_H__
+#define __TEXTURE_CACHE_H__
+
+#include "mask.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A process-wide cache of the textures loaded from image files, keyed by
+ * path, so every asset is decoded and uploaded to the GPU only once no
+ * matter how many sprites show it.
+ * Entries are reference counted: every texture_cache_acquire() hands the
+ * caller one reference, which must eventually be given back with
+ * texture_cache_release() (or handed to a sprite, which releases it).
+ * Textures whose last reference is released stay cached, so reloading a
+ * level reuses them, until the memory budget forces them out in least
+ * recently used order.
+ * Small images can also be packed into a shared atlas texture up front
+ * (see texture_cache_pack()), so the sprites showing them can be drawn
+ * without switching textures.
+ */
+
+/**
+ * Gets the texture of an image file, loading it on first use.
+ * Packed images come back as their atlas page.
+ *
+ * @param path the image file
+ * @param region if non-NULL, set to the part of the texture showing the
+ *   image; this is the whole texture unless the image was packed
+ * @return the shared texture, with one new reference
+ */
+SDL_Texture *texture_cache_acquire(const char *path, SDL_Rect *region);
+
+/**
+ * Gets the texture of an image file along with the collision mask of its
+ * opaque pixels (see mask.h), loading either on first use.
+ * The mask belongs to the cache and lives as long as the texture is
+ * referenced.
+ *
+ * @param path the image file
+ * @param mask set to the shared mask
+ * @param region if non-NULL, set to the part of the texture showing the
+ *   image
+ * @return the shared texture, with one new reference
+ */
+SDL_Texture *texture_cache_acquire_with_mask(const char *path, mask_t **mask,
+                                             SDL_Rect *region);
+
+/**
+ * Loads a set of images and packs the ones that fit into atlas pages
+ * (see sprite_atlas.h), which stay cached for the rest of the program.
+ * Call it once, at load time, before the images are first acquired;
+ * images that are already cached are left as they are.
+ *
+ * @param paths the image files
+ * @param count the number of image files
+ */
+void texture_cache_pack(const char **paths, size_t count);
+
+/**
+ * Gives back a reference to a cached texture.
+ * Textures that are not in the cache are left alone.
+ *
+ * @param texture a texture returned from texture_cache_acquire()
+ * @return whether the texture was in the cache
+ */
+bool texture_cache_release(SDL_Texture *texture);
+
+/**
+ * Limits how much memory cached textures may use.
+ * Unreferenced textures are destroyed, least recently used first, while the
+ * cache is over budget; referenced textures are never destroyed, so the
+ * budget can be exceeded while they are in use.
+ *
+ * @param bytes the budget in bytes, or 0 for no limit (the default)
+ */
+void texture_cache_set_budget(size_t bytes);
+
+/**
+ * Gets the memory used by the cached textures, estimated from their sizes
+ * at four bytes per pixel.
+ *
+ * @return the number of bytes
+ */
+size_t texture_cache_get_bytes(void);
+
+/**
+ * Destroys every cached texture that is no longer referenced.
+ */
+void texture_cache_purge(void);
+
+#endif // #ifndef __TEXTURE_CACHE_H__
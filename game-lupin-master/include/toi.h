@@ -0,0 +1,80 @@
+#ifndef __TOI_H__
+#define __TOI_H__
+
+#include "broadphase.h"
+#include "list.h"
+#include <stddef.h>
+
+/**
+ * Event-driven simulation for ballistic scenes, where every body moves in a
+ * straight line at constant velocity between impacts.
+ * The time of impact (TOI) of each interacting pair is predicted from its
+ * swept bounding boxes and kept in a priority queue; a tick then jumps from
+ * impact to impact instead of checking every pair at fixed steps.
+ * Each prediction records the motion versions of its bodies
+ * (see body_get_version()), so predictions go stale by themselves when a
+ * paddle changes velocity or a pellet is reset, and only the pairs of bodies
+ * whose motion changed are predicted again.
+ * Sensor pairs also get a prediction of when their boxes separate,
+ * so they report end events just as stepped ticks do.
+ * Since impacts are found from bounding boxes, bodies collide as their boxes,
+ * which suits the axis-aligned walls and paddles of pong; scenes with bodies
+ * that collide with their pixels are stepped instead.
+ */
+typedef struct toi toi_t;
+
+/**
+ * Allocates memory for an empty impact queue.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new queue
+ */
+toi_t *toi_init(void);
+
+/**
+ * Releases the memory allocated for an impact queue.
+ *
+ * @param toi a pointer to a queue returned from toi_init()
+ */
+void toi_free(toi_t *toi);
+
+/**
+ * Discards every prediction, so the next toi_advance() predicts all pairs.
+ * Needed after the bodies were moved by anything other than toi_advance(),
+ * such as a regular scene step, which doesn't change motion versions.
+ *
+ * @param toi a pointer to a queue returned from toi_init()
+ */
+void toi_invalidate(toi_t *toi);
+
+/**
+ * Drops the predictions involving a body that is about to be freed.
+ *
+ * @param toi a pointer to a queue returned from toi_init()
+ * @param body the body being removed
+ */
+void toi_remove_body(toi_t *toi, body_t *body);
+
+/**
+ * Advances ballistic bodies by dt, resolving every impact on the way in time
+ * order with broadphase_impact().
+ * Gives up if a single call reaches a cap on impacts (e.g. a pellet pinched
+ * between a paddle and a wall), leaving the rest of the time to the caller.
+ *
+ * @param toi a pointer to a queue returned from toi_init()
+ * @param bodies the bodies of the scene
+ * @param bp the scene's broad phase, for collision filters and rules
+ * @param dt the time to advance, in seconds
+ * @return the time left to simulate some other way; 0 if all went through
+ */
+double toi_advance(toi_t *toi, list_t *bodies, broadphase_t *bp, double dt);
+
+/**
+ * Gets the number of impacts resolved by the last toi_advance().
+ *
+ * @param toi a pointer to a queue returned from toi_init()
+ * @return the number of impacts
+ */
+size_t toi_last_impacts(toi_t *toi);
+
+#endif // #ifndef __TOI_H__
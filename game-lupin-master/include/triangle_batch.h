@@ -0,0 +1,64 @@
+#ifndef __TRIANGLE_BATCH_H__
+#define __TRIANGLE_BATCH_H__
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+
+/**
+ * A growing buffer of indexed triangles that are drawn together with one
+ * SDL_RenderGeometry() call.
+ * Every vertex carries its own color, so polygons of different colors can
+ * share a batch.
+ * Flushing empties the batch but keeps its memory, so a batch that is
+ * refilled every frame only allocates when it outgrows every earlier frame.
+ */
+typedef struct triangle_batch triangle_batch_t;
+
+/**
+ * Allocates memory for an empty batch.
+ * Asserts that the required memory is successfully allocated.
+ *
+ * @return the new batch
+ */
+triangle_batch_t *triangle_batch_init(void);
+
+/**
+ * Releases the memory allocated for a batch.
+ *
+ * @param batch a pointer to a batch returned from triangle_batch_init()
+ */
+void triangle_batch_free(triangle_batch_t *batch);
+
+/**
+ * Adds a triangulated polygon to a batch.
+ * The caller fills in the returned vertices before the next add or flush.
+ *
+ * @param batch the batch
+ * @param vertex_count the number of vertices in the polygon
+ * @param indices the polygon's triangles, as indices into its own vertices
+ * @param index_count the number of indices, three per triangle
+ * @return room for the polygon's vertices, owned by the batch
+ */
+SDL_Vertex *triangle_batch_add(triangle_batch_t *batch, size_t vertex_count,
+                               const int *indices, size_t index_count);
+
+/**
+ * Gets the number of triangles waiting in a batch.
+ *
+ * @param batch the batch
+ * @return the number of triangles added since the last flush
+ */
+size_t triangle_batch_size(triangle_batch_t *batch);
+
+/**
+ * Draws every triangle in a batch with one SDL_RenderGeometry() call
+ * and empties the batch. Does nothing if the batch is empty.
+ *
+ * @param batch the batch
+ * @param renderer the renderer to draw with
+ * @param texture the texture the vertices are mapped onto, or NULL
+ */
+void triangle_batch_flush(triangle_batch_t *batch, SDL_Renderer *renderer,
+                          SDL_Texture *texture);
+
+#endif // #ifndef __TRIANGLE_BATCH_H__
@@ -1,12 +1,16 @@
 #include "body.h"
+#include "collision.h"
 #include "color.h"
 #include "forces.h"
 #include "list.h"
+#include "mask.h"
 #include "polygon.h"
+#include "prototype.h"
 #include "scene.h"
 #include "sdl_wrapper.h"
 #include "shapes.h"
 #include "sprite.h"
+#include "texture_cache.h"
 #include "vector.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -15,63 +19,141 @@
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_ttf.h>
 #include <assert.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-typedef struct body {
-  list_t *shape;
-  double angle;
+// Pixel contacts are found inside the polygon, so its depth overstates them
+static const double MAX_PIXEL_CONTACT_DEPTH = 1;
+static const size_t INIT_POOL_CAPACITY = 16;
+// Bodies in the same cell of this size (in pixels) share a Z-order key
+static const double MORTON_CELL_SIZE = 16;
+// Cell coordinates are clamped to 16 bits so two fit in one key
+static const double MORTON_MAX_CELL = UINT16_MAX;
+
+/**
+ * The part of a body the physics loops read and write every tick.
+ * A body in a scene keeps it in the scene's body pool, so those loops walk
+ * it contiguously; a body outside any pool keeps it in own_motion.
+ */
+typedef struct body_motion {
+  prototype_t *proto;
+  vector_t centroid;
   vector_t vel;
-  double rot_vel;
   vector_t acc;
-  double mass;
-  rgb_color_t color;
   vector_t tot_force;
   vector_t tot_impulse;
-  vector_t centroid;
+  double angle;
+  double cos_angle;
+  double sin_angle;
+  double rot_vel;
+  double mass;
+  double drag;
+  aabb_t local_bounds;
+  bool sleeping;
+} body_motion_t;
+
+typedef struct body {
+  // own_motion, or the body's slot in a body pool; the slot moves when the
+  // pool grows or is sorted, but the body itself never does
+  body_motion_t *motion;
+  body_motion_t own_motion;
+  rgb_color_t color;
+  double rest_time;
+  size_t island;
+  uint32_t category;
+  uint32_t mask;
+  bool sensor;
+  bool pixel_collision;
+  bool is_static;
+  size_t version;
   bool to_remove;
   void *info;
   sprite_t *sprite_info;
   free_func_t info_freer;
 } body_t;
 
+/** Where a body's motion should go when a pool is sorted */
+typedef struct pool_entry {
+  uint32_t key;
+  size_t index;
+  body_t *body;
+} pool_entry_t;
+
+typedef struct body_pool {
+  // the motion of bodies[i] is motions[i]
+  body_motion_t *motions;
+  body_t **bodies;
+  size_t size;
+  size_t capacity;
+  // scratch space for body_pool_sort(), reused from one sort to the next
+  pool_entry_t *entries;
+  body_motion_t *sorted;
+} body_pool_t;
+
+/**
+ * Scratch arrays body_find_collision() copies the two bodies' vertices
+ * into, reused by every narrow phase check so it never allocates once they
+ * fit the largest shapes.
+ */
+static vector_t *collision_vertices[2] = {NULL, NULL};
+static size_t collision_capacity[2] = {0, 0};
+
 void body_set_default_properties(body_t *body, double mass) {
   assert(mass > 0);
-  body->angle = 0;
-  body->vel = VEC_ZERO;
-  body->rot_vel = 0;
-  body->acc = VEC_ZERO;
-  body->mass = mass;
-  body->tot_force = (vector_t){.x = 0, .y = 0};
-  body->tot_impulse = (vector_t){.x = 0, .y = 0};
-  body->centroid = polygon_centroid(body->shape);
+  body->motion->angle = 0;
+  body->motion->cos_angle = 1;
+  body->motion->sin_angle = 0;
+  body->motion->vel = VEC_ZERO;
+  body->motion->rot_vel = 0;
+  body->motion->acc = VEC_ZERO;
+  body->motion->mass = mass;
+  body->motion->drag = 0;
+  body->motion->tot_force = (vector_t){.x = 0, .y = 0};
+  body->motion->tot_impulse = (vector_t){.x = 0, .y = 0};
+  body->motion->local_bounds = prototype_get_bounds(body->motion->proto);
+  body->motion->sleeping = false;
+  body->rest_time = 0;
+  body->island = 0;
+  body->category = 0;
+  body->mask = UINT32_MAX;
+  body->sensor = false;
+  body->pixel_collision = false;
+  body->is_static = false;
+  body->version = 0;
   body->to_remove = false;
   body->info = NULL;
   body->info_freer = NULL;
 }
 
-list_t *body_get_sprite_rect(body_t *body) {
-  int *w = malloc(sizeof(int));
-  int *h = malloc(sizeof(int));
-  SDL_QueryTexture(sprite_get_texture(body->sprite_info), NULL, NULL, w, h);
-  list_t *shape = make_rect(*w, *h);
-  vector_t diff = vec_subtract(body->centroid, polygon_centroid(shape));
-  polygon_translate(shape, diff);
-  free(w);
-  free(h);
-  return shape;
+prototype_t *body_get_sprite_rect(body_t *body) {
+  SDL_Rect region = sprite_get_region(body->sprite_info);
+  double scaling = sprite_get_scaling(body->sprite_info);
+  return prototype_rect(scaling * region.w, scaling * region.h);
 }
 
-body_t *body_init_shape(list_t *shape, double mass, rgb_color_t color) {
+body_t *body_init_prototype(prototype_t *proto, double mass,
+                            rgb_color_t color) {
   body_t *body = malloc(sizeof(body_t));
   assert(body != NULL);
-  body->shape = shape;
+  body->motion = &body->own_motion;
+  body->motion->proto = proto;
+  body->motion->centroid = VEC_ZERO;
   body->sprite_info = sprite_init();
   body->color = color;
   body_set_default_properties(body, mass);
   return body;
 }
 
+body_t *body_init_shape(list_t *shape, double mass, rgb_color_t color) {
+  vector_t centroid;
+  prototype_t *proto = prototype_init(shape, &centroid);
+  body_t *body = body_init_prototype(proto, mass, color);
+  body->motion->centroid = centroid;
+  return body;
+}
+
 body_t *body_init_shape_with_info(list_t *shape, double mass, rgb_color_t color,
                                   void *info, free_func_t info_freer) {
   body_t *body = body_init_shape(shape, mass, color);
@@ -84,11 +166,14 @@ body_t *body_init_texture_path_scaled(const char *texture_file, double scaling,
                                       vector_t centroid, double mass) {
   body_t *body = malloc(sizeof(body_t));
   assert(body != NULL);
-  body->centroid = centroid;
+  body->motion = &body->own_motion;
+  body->motion->centroid = centroid;
   body->sprite_info = sprite_init();
   body_set_texture_scaled(body, texture_file, scaling);
-  body->shape = body_get_sprite_rect(body);
+  body->motion->proto = body_get_sprite_rect(body);
   body_set_default_properties(body, mass);
+  // the shape is the whole image, so let the opaque pixels decide contact
+  body->pixel_collision = true;
   return body;
 }
 
@@ -104,7 +189,7 @@ bool body_is_removed(body_t *body) { return body->to_remove; }
 void *body_get_info(body_t *body) { return body->info; }
 
 void body_free(body_t *body) {
-  list_free(body->shape);
+  prototype_release(body->motion->proto);
   if (body->info_freer != NULL) {
     body->info_freer(body->info);
   }
@@ -112,73 +197,234 @@ void body_free(body_t *body) {
   free(body);
 }
 
+prototype_t *body_get_prototype(body_t *body) { return body->motion->proto; }
+
+size_t body_get_vertex_count(body_t *body) {
+  return prototype_size(body->motion->proto);
+}
+
+/** Rotates a vertex of the prototype by the body's current angle */
+vector_t body_orient_vertex(body_t *body, size_t index) {
+  body_motion_t *motion = body->motion;
+  vector_t local = prototype_get_vertex(motion->proto, index);
+  return (vector_t){
+      .x = local.x * motion->cos_angle - local.y * motion->sin_angle,
+      .y = local.x * motion->sin_angle + local.y * motion->cos_angle};
+}
+
+vector_t body_get_vertex(body_t *body, size_t index) {
+  return vec_add(body->motion->centroid, body_orient_vertex(body, index));
+}
+
 list_t *body_get_shape(body_t *body) {
-  return deepcopy(body->shape, (copy_func_t)vec_copy);
+  size_t size = prototype_size(body->motion->proto);
+  list_t *shape = list_init(size, free);
+  for (size_t i = 0; i < size; i++) {
+    vector_t *vertex = malloc(sizeof(vector_t));
+    assert(vertex != NULL);
+    *vertex = body_get_vertex(body, i);
+    list_add(shape, vertex);
+  }
+  return shape;
 }
 
-vector_t body_get_centroid(body_t *body) { return body->centroid; }
+vector_t body_get_centroid(body_t *body) { return body->motion->centroid; }
+
+vector_t body_get_velocity(body_t *body) { return body->motion->vel; }
 
-vector_t body_get_velocity(body_t *body) { return body->vel; }
+double body_get_mass(body_t *body) { return body->motion->mass; }
 
-double body_get_mass(body_t *body) { return body->mass; }
+double body_get_inverse_mass(body_t *body) {
+  return body->motion->mass == INFINITY ? 0 : 1 / body->motion->mass;
+}
 
 rgb_color_t body_get_color(body_t *body) { return body->color; }
 
+double body_get_area(body_t *body) {
+  return prototype_get_area(body->motion->proto);
+}
+
+double body_get_radius(body_t *body) {
+  return prototype_get_radius(body->motion->proto);
+}
+
+aabb_t body_get_bounds(body_t *body) {
+  return aabb_translate(body->motion->local_bounds, body->motion->centroid);
+}
+
 void body_set_centroid(body_t *body, vector_t x) {
-  body->centroid = x;
-  vector_t curr_pos = polygon_centroid(body->shape);
-  vector_t difference = vec_subtract(x, curr_pos);
-  polygon_translate(body->shape, difference);
+  body->motion->centroid = x;
+  body->version++;
+  body_wake(body);
 }
 
 void body_move_centroid(body_t *body, vector_t x) {
-  body->centroid = vec_add(body->centroid, x);
-  polygon_translate(body->shape, x);
+  body->motion->centroid = vec_add(body->motion->centroid, x);
 }
 
-void body_set_velocity(body_t *body, vector_t v) { body->vel = v; }
+/**
+ * Sets the absolute orientation used to place the prototype's vertices,
+ * recomputing the rotated bounding box relative to the centroid.
+ * The centroid, area and bounding radius are invariant under rotation.
+ */
+void body_orient(body_t *body, double angle) {
+  if (angle == body->motion->angle) {
+    return;
+  }
+  body->motion->angle = angle;
+  body->version++;
+  body->motion->cos_angle = cos(angle);
+  body->motion->sin_angle = sin(angle);
+  vector_t first = body_orient_vertex(body, 0);
+  aabb_t bounds = {.min = first, .max = first};
+  for (size_t i = 1; i < prototype_size(body->motion->proto); i++) {
+    vector_t curr = body_orient_vertex(body, i);
+    bounds.min.x = fmin(bounds.min.x, curr.x);
+    bounds.min.y = fmin(bounds.min.y, curr.y);
+    bounds.max.x = fmax(bounds.max.x, curr.x);
+    bounds.max.y = fmax(bounds.max.y, curr.y);
+  }
+  body->motion->local_bounds = bounds;
+}
 
-void body_set_rotation(body_t *body, double angle) {
-  double angle_difference = angle - body->angle;
-  polygon_rotate(body->shape, angle_difference, body_get_centroid(body));
-  body->angle = angle;
+void body_set_velocity(body_t *body, vector_t v) {
+  if (v.x != body->motion->vel.x || v.y != body->motion->vel.y) {
+    body->version++;
+  }
+  body->motion->vel = v;
+  if (v.x != 0 || v.y != 0) {
+    body_wake(body);
+  }
 }
 
+void body_set_rotation(body_t *body, double angle) { body_orient(body, angle); }
+
 void body_rotate(body_t *body, double angle) {
-  polygon_rotate(body->shape, angle, body->centroid);
-  body->angle = body->angle + angle;
+  body_orient(body, body->motion->angle + angle);
 }
 
 void body_add_force(body_t *body, vector_t force) {
-  body->tot_force = vec_add(body->tot_force, force);
+  body->motion->tot_force = vec_add(body->motion->tot_force, force);
 }
 
 void body_add_impulse(body_t *body, vector_t impulse) {
-  body->tot_impulse = vec_add(body->tot_impulse, impulse);
+  body->motion->tot_impulse = vec_add(body->motion->tot_impulse, impulse);
+  if (impulse.x != 0 || impulse.y != 0) {
+    body->version++;
+    body_wake(body);
+  }
 }
+vector_t body_get_force(body_t *body) { return body->motion->tot_force; }
+
+vector_t body_get_impulse(body_t *body) { return body->motion->tot_impulse; }
+
 void body_change_direction(body_t *body, vector_t dir) {
   double body_speed = vec_magnitude(body_get_velocity(body));
-  vector_t impulse = vec_multiply(body->mass * body_speed, dir);
-  body->tot_impulse = vec_add(body->tot_impulse, impulse);
+  vector_t impulse = vec_multiply(body->motion->mass * body_speed, dir);
+  body->motion->tot_impulse = vec_add(body->motion->tot_impulse, impulse);
 }
 void body_tick(body_t *body, double dt) {
-  body->acc = vec_multiply(1 / body->mass, body->tot_force);
-  vector_t new_vel = vec_add(
-      body->vel, vec_add(vec_multiply(1 / body->mass, body->tot_impulse),
-                         vec_multiply(dt, body->acc)));
-  vector_t avg_vel = vec_multiply(.5, vec_add(body->vel, new_vel));
-  body->vel = new_vel;
-  body_move_centroid(body, vec_multiply(dt, avg_vel));
-  body_rotate(body, dt * body->rot_vel);
-  body->tot_force = VEC_ZERO;
-  body->tot_impulse = VEC_ZERO;
-  body->acc = VEC_ZERO;
-}
-
-void body_set_acceleration(body_t *body, vector_t acc) { body->acc = acc; }
-vector_t body_get_acceleration(body_t *body) { return body->acc; }
-double body_get_rot_velocity(body_t *body) { return body->rot_vel; }
-void body_set_rot_velocity(body_t *body, double rv) { body->rot_vel = rv; }
+  body_motion_t *motion = body->motion;
+  if (motion->sleeping) {
+    motion->tot_force = VEC_ZERO;
+    return;
+  }
+  motion->acc = vec_multiply(1 / motion->mass, motion->tot_force);
+  vector_t kicked =
+      vec_add(motion->vel, vec_multiply(1 / motion->mass, motion->tot_impulse));
+  if (motion->drag == 0) {
+    vector_t new_vel = vec_add(kicked, vec_multiply(dt, motion->acc));
+    vector_t avg_vel = vec_multiply(.5, vec_add(motion->vel, new_vel));
+    motion->vel = new_vel;
+    body_move_centroid(body, vec_multiply(dt, avg_vel));
+  } else {
+    vector_t displacement;
+    motion->vel =
+        body_drag_velocity(body, kicked, motion->acc, dt, &displacement);
+    body_move_centroid(body, displacement);
+  }
+  body_rotate(body, dt * motion->rot_vel);
+  body_clear_forces(body);
+}
+
+void body_clear_forces(body_t *body) {
+  body->motion->tot_force = VEC_ZERO;
+  body->motion->tot_impulse = VEC_ZERO;
+  body->motion->acc = VEC_ZERO;
+}
+
+void body_set_drag(body_t *body, double gamma) { body->motion->drag = gamma; }
+
+double body_get_drag(body_t *body) { return body->motion->drag; }
+
+vector_t body_drag_velocity(body_t *body, vector_t vel, vector_t acc, double dt,
+                            vector_t *displacement) {
+  double rate = body->motion->drag / body->motion->mass;
+  if (rate == 0) {
+    if (displacement != NULL) {
+      *displacement = vec_add(vec_multiply(dt, vel),
+                              vec_multiply(.5 * dt * dt, acc));
+    }
+    return vec_add(vel, vec_multiply(dt, acc));
+  }
+  double decay = exp(-rate * dt);
+  vector_t terminal = vec_multiply(1 / rate, acc);
+  vector_t excess = vec_subtract(vel, terminal);
+  if (displacement != NULL) {
+    *displacement = vec_add(vec_multiply(dt, terminal),
+                            vec_multiply((1 - decay) / rate, excess));
+  }
+  return vec_add(terminal, vec_multiply(decay, excess));
+}
+
+bool body_is_sleeping(body_t *body) { return body->motion->sleeping; }
+
+void body_sleep(body_t *body) {
+  body->motion->sleeping = true;
+  body->motion->vel = VEC_ZERO;
+  body->motion->rot_vel = 0;
+  body->motion->tot_force = VEC_ZERO;
+  body->motion->tot_impulse = VEC_ZERO;
+}
+
+void body_wake(body_t *body) {
+  if (body->motion->sleeping) {
+    body->motion->sleeping = false;
+    body->rest_time = 0;
+  }
+}
+
+double body_get_rest_time(body_t *body) { return body->rest_time; }
+
+void body_set_rest_time(body_t *body, double time) { body->rest_time = time; }
+
+size_t body_get_island(body_t *body) { return body->island; }
+
+void body_set_island(body_t *body, size_t island) { body->island = island; }
+
+void body_set_collision_filter(body_t *body, uint32_t category, uint32_t mask) {
+  body->category = category;
+  body->mask = mask;
+}
+
+uint32_t body_get_category(body_t *body) { return body->category; }
+
+uint32_t body_get_mask(body_t *body) { return body->mask; }
+
+void body_set_sensor(body_t *body, bool sensor) { body->sensor = sensor; }
+
+bool body_is_sensor(body_t *body) { return body->sensor; }
+
+size_t body_get_version(body_t *body) { return body->version; }
+
+void body_set_acceleration(body_t *body, vector_t acc) {
+  body->motion->acc = acc;
+}
+vector_t body_get_acceleration(body_t *body) { return body->motion->acc; }
+double body_get_rot_velocity(body_t *body) { return body->motion->rot_vel; }
+void body_set_rot_velocity(body_t *body, double rv) {
+  body->motion->rot_vel = rv;
+}
 
 sprite_t *body_get_sprite(body_t *body) { return body->sprite_info; }
 
@@ -188,8 +434,143 @@ void body_set_texture(body_t *body, const char *texture_file) {
 
 void body_set_texture_scaled(body_t *body, const char *texture_file,
                              double scaling) {
-  SDL_Texture *texture = sdl_create_texture(texture_file);
+  mask_t *mask;
+  SDL_Rect region;
+  SDL_Texture *texture =
+      texture_cache_acquire_with_mask(texture_file, &mask, &region);
   sprite_set_texture_scaled(body->sprite_info, texture, scaling);
+  sprite_set_region(body->sprite_info, region);
+  sprite_set_mask(body->sprite_info, mask);
+}
+
+void body_set_pixel_collision(body_t *body, bool pixel_collision) {
+  body->pixel_collision = pixel_collision;
+}
+
+bool body_has_pixel_collision(body_t *body) { return body->pixel_collision; }
+
+void body_set_static(body_t *body, bool is_static) {
+  body->is_static = is_static;
+}
+
+bool body_is_static(body_t *body) { return body->is_static; }
+
+/** Gets the mask a body collides with, if it uses one in its current pose */
+mask_t *body_collision_mask(body_t *body) {
+  mask_t *mask = sprite_get_mask(body->sprite_info);
+  // masks are axis-aligned, so a turned body falls back to its polygon
+  if (!body->pixel_collision || mask == NULL || body->motion->sin_angle != 0 ||
+      body->motion->cos_angle != 1) {
+    return NULL;
+  }
+  return mask;
+}
+
+/** Gets the size in the scene of one pixel of a body's mask */
+double body_mask_scale(body_t *body) {
+  return sprite_get_scaling(body->sprite_info);
+}
+
+/** Gets the scene position of the top left corner of a body's mask */
+vector_t body_mask_corner(body_t *body, mask_t *mask) {
+  double scale = body_mask_scale(body);
+  return (vector_t){body->motion->centroid.x - scale * mask_width(mask) / 2.0,
+                    body->motion->centroid.y + scale * mask_height(mask) / 2.0};
+}
+
+/**
+ * Returns whether an opaque pixel of a masked body lies inside the
+ * (convex) shape of another body, scanning the mask rows the shape covers.
+ */
+bool body_mask_touches_shape(body_t *masked, mask_t *mask, body_t *other) {
+  vector_t corner = body_mask_corner(masked, mask);
+  double scale = body_mask_scale(masked);
+  aabb_t bounds = body_get_bounds(other);
+  int first_row = (int)floor((corner.y - bounds.max.y) / scale);
+  int last_row = (int)ceil((corner.y - bounds.min.y) / scale);
+  size_t size = body_get_vertex_count(other);
+  for (int row = first_row; row <= last_row; row++) {
+    double y = corner.y - (row + 0.5) * scale;
+    double min_x = INFINITY;
+    double max_x = -INFINITY;
+    for (size_t i = 0; i < size; i++) {
+      vector_t p = body_get_vertex(other, i);
+      vector_t q = body_get_vertex(other, (i + 1) % size);
+      if ((p.y <= y && q.y >= y) || (q.y <= y && p.y >= y)) {
+        double x =
+            p.y == q.y ? p.x : p.x + (y - p.y) * (q.x - p.x) / (q.y - p.y);
+        min_x = fmin(min_x, x);
+        max_x = fmax(max_x, x);
+      }
+    }
+    if (min_x <= max_x &&
+        mask_row_any(mask, row, (int)floor((min_x - corner.x) / scale),
+                     (int)ceil((max_x - corner.x) / scale))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** Refines a polygon contact with the bodies' masks, if they use them */
+bool body_pixels_touch(body_t *body1, body_t *body2) {
+  mask_t *mask1 = body_collision_mask(body1);
+  mask_t *mask2 = body_collision_mask(body2);
+  if (mask1 == NULL && mask2 == NULL) {
+    return true;
+  }
+  if (mask1 == NULL) {
+    return body_mask_touches_shape(body2, mask2, body1);
+  }
+  if (mask2 == NULL) {
+    return body_mask_touches_shape(body1, mask1, body2);
+  }
+  double scale = body_mask_scale(body1);
+  if (body_mask_scale(body2) != scale) {
+    // pixels of different sizes can't be compared one to one, so check
+    // each mask against the other body's polygon instead
+    return body_mask_touches_shape(body1, mask1, body2) &&
+           body_mask_touches_shape(body2, mask2, body1);
+  }
+  vector_t corner1 = body_mask_corner(body1, mask1);
+  vector_t corner2 = body_mask_corner(body2, mask2);
+  return mask_overlap(mask1, mask2,
+                      (int)lround((corner2.x - corner1.x) / scale),
+                      (int)lround((corner1.y - corner2.y) / scale));
+}
+
+/**
+ * Places a body's current vertices in one of the narrow phase's scratch
+ * arrays, growing it if needed, and views them as a polygon.
+ * The view is valid until the slot is next used.
+ */
+polygon_view_t body_collision_view(body_t *body, size_t slot) {
+  size_t size = prototype_size(body->motion->proto);
+  if (size > collision_capacity[slot]) {
+    collision_vertices[slot] =
+        realloc(collision_vertices[slot], sizeof(vector_t) * size);
+    assert(collision_vertices[slot] != NULL);
+    collision_capacity[slot] = size;
+  }
+  for (size_t i = 0; i < size; i++) {
+    collision_vertices[slot][i] = body_get_vertex(body, i);
+  }
+  return (polygon_view_t){.points = collision_vertices[slot], .size = size};
+}
+
+collision_info_t body_find_collision(body_t *body1, body_t *body2,
+                                     collision_cache_t *cache) {
+  collision_info_t info = find_collision_view(
+      body_collision_view(body1, 0), body_collision_view(body2, 1), cache);
+  if (info.collided && (body_collision_mask(body1) != NULL ||
+                        body_collision_mask(body2) != NULL)) {
+    info.collided = body_pixels_touch(body1, body2);
+    // The polygons' depth measures to the edge of the image's rectangle,
+    // which may be far from where the opaque pixels first touched;
+    // correcting by all of it would throw the bodies apart in one tick
+    info.depth = fmin(info.depth, MAX_PIXEL_CONTACT_DEPTH);
+  }
+  return info;
 }
 
 bool body_has_sprite(body_t *body) {
@@ -200,5 +581,136 @@ void body_print(body_t *body) {
   printf("Body pos:(%f, %f), vel:(%f, %f), tot_force(%f, %f)\n",
          body_get_centroid(body).x, body_get_centroid(body).y,
          body_get_velocity(body).x, body_get_velocity(body).y,
-         (body->tot_force).x, (body->tot_force).y);
-}
\ No newline at end of file
+         (body->motion->tot_force).x, (body->motion->tot_force).y);
+}
+body_pool_t *body_pool_init(void) {
+  body_pool_t *pool = malloc(sizeof(body_pool_t));
+  assert(pool != NULL);
+  pool->capacity = INIT_POOL_CAPACITY;
+  pool->size = 0;
+  pool->motions = malloc(sizeof(body_motion_t) * pool->capacity);
+  pool->bodies = malloc(sizeof(body_t *) * pool->capacity);
+  pool->entries = malloc(sizeof(pool_entry_t) * pool->capacity);
+  pool->sorted = malloc(sizeof(body_motion_t) * pool->capacity);
+  assert(pool->motions != NULL && pool->bodies != NULL &&
+         pool->entries != NULL && pool->sorted != NULL);
+  return pool;
+}
+
+void body_pool_free(body_pool_t *pool) {
+  free(pool->motions);
+  free(pool->bodies);
+  free(pool->entries);
+  free(pool->sorted);
+  free(pool);
+}
+
+/** Points the bodies from first on at their slots, after the slots moved */
+void body_pool_relink(body_pool_t *pool, size_t first) {
+  for (size_t i = first; i < pool->size; i++) {
+    pool->bodies[i]->motion = &pool->motions[i];
+  }
+}
+
+void body_pool_reserve(body_pool_t *pool, size_t size) {
+  if (size <= pool->capacity) {
+    return;
+  }
+  while (pool->capacity < size) {
+    pool->capacity *= 2;
+  }
+  pool->motions =
+      realloc(pool->motions, sizeof(body_motion_t) * pool->capacity);
+  pool->bodies = realloc(pool->bodies, sizeof(body_t *) * pool->capacity);
+  pool->entries =
+      realloc(pool->entries, sizeof(pool_entry_t) * pool->capacity);
+  pool->sorted = realloc(pool->sorted, sizeof(body_motion_t) * pool->capacity);
+  assert(pool->motions != NULL && pool->bodies != NULL &&
+         pool->entries != NULL && pool->sorted != NULL);
+  body_pool_relink(pool, 0);
+}
+
+void body_pool_add(body_pool_t *pool, body_t *body) {
+  assert(body->motion == &body->own_motion);
+  body_pool_reserve(pool, pool->size + 1);
+  pool->motions[pool->size] = body->own_motion;
+  pool->bodies[pool->size] = body;
+  body->motion = &pool->motions[pool->size];
+  pool->size++;
+}
+
+body_t *body_pool_remove(body_pool_t *pool, size_t index) {
+  assert(index < pool->size);
+  body_t *body = pool->bodies[index];
+  body->own_motion = pool->motions[index];
+  body->motion = &body->own_motion;
+  for (size_t i = index + 1; i < pool->size; i++) {
+    pool->motions[i - 1] = pool->motions[i];
+    pool->bodies[i - 1] = pool->bodies[i];
+  }
+  pool->size--;
+  body_pool_relink(pool, index);
+  return body;
+}
+
+size_t body_pool_size(body_pool_t *pool) { return pool->size; }
+
+body_t *body_pool_get(body_pool_t *pool, size_t index) {
+  assert(index < pool->size);
+  return pool->bodies[index];
+}
+
+/** Spreads the low 16 bits of v out to the even bits */
+uint32_t morton_spread(uint32_t v) {
+  v &= 0xFFFF;
+  v = (v | (v << 8)) & 0x00FF00FF;
+  v = (v | (v << 4)) & 0x0F0F0F0F;
+  v = (v | (v << 2)) & 0x33333333;
+  v = (v | (v << 1)) & 0x55555555;
+  return v;
+}
+
+/** Gets the cell an offset from the pool's corner falls in */
+uint32_t morton_cell(double offset) {
+  return (uint32_t)fmin(fmax(floor(offset / MORTON_CELL_SIZE), 0),
+                        MORTON_MAX_CELL);
+}
+
+/** Orders entries by key, keeping bodies in the same cell in their order */
+int pool_entry_compare(const void *a, const void *b) {
+  const pool_entry_t *entry1 = a;
+  const pool_entry_t *entry2 = b;
+  if (entry1->key != entry2->key) {
+    return entry1->key < entry2->key ? -1 : 1;
+  }
+  return entry1->index < entry2->index ? -1 : entry1->index > entry2->index;
+}
+
+void body_pool_sort(body_pool_t *pool) {
+  if (pool->size < 2) {
+    return;
+  }
+  vector_t corner = pool->motions[0].centroid;
+  for (size_t i = 1; i < pool->size; i++) {
+    corner.x = fmin(corner.x, pool->motions[i].centroid.x);
+    corner.y = fmin(corner.y, pool->motions[i].centroid.y);
+  }
+  // each key is computed once, not on every comparison
+  for (size_t i = 0; i < pool->size; i++) {
+    vector_t offset = vec_subtract(pool->motions[i].centroid, corner);
+    pool->entries[i] = (pool_entry_t){
+        .key = morton_spread(morton_cell(offset.x)) |
+               morton_spread(morton_cell(offset.y)) << 1,
+        .index = i,
+        .body = pool->bodies[i]};
+  }
+  qsort(pool->entries, pool->size, sizeof(pool_entry_t), pool_entry_compare);
+  for (size_t i = 0; i < pool->size; i++) {
+    pool->sorted[i] = pool->motions[pool->entries[i].index];
+    pool->bodies[i] = pool->entries[i].body;
+  }
+  body_motion_t *motions = pool->motions;
+  pool->motions = pool->sorted;
+  pool->sorted = motions;
+  body_pool_relink(pool, 0);
+}
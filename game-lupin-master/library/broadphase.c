@@ -0,0 +1,531 @@
+#include "broadphase.h"
+#include "body.h"
+#include "collision.h"
+#include "list.h"
+#include "polygon.h"
+#include "solver.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static const size_t INIT_PROXIES_CAPACITY = 16;
+static const size_t INIT_RULES_SIZE = 4;
+static const size_t INIT_EVENTS_CAPACITY = 8;
+static const size_t INIT_BUCKET_COUNT = 64;
+// Grow the pair table once it holds this many pairs per bucket
+static const size_t MAX_LOAD_FACTOR = 1;
+
+typedef struct rule {
+  uint32_t category1;
+  uint32_t category2;
+  double elasticity;
+  collision_handler_t handler;
+  void *aux;
+  free_func_t freer;
+} rule_t;
+
+typedef struct proxy {
+  body_t *body;
+  aabb_t bounds;
+} proxy_t;
+
+typedef struct pair {
+  // ordered as the rule expects them (sensor first), not as they are hashed
+  body_t *body1;
+  body_t *body2;
+  // NULL for sensor pairs
+  rule_t *rule;
+  contact_t *contact;
+  // narrow phase state for pairs without a contact
+  collision_cache_t cache;
+  bool touching;
+  size_t stamp;
+  struct pair *next;
+} pair_t;
+
+typedef struct broadphase {
+  proxy_t *proxies;
+  size_t proxy_count;
+  size_t proxy_capacity;
+  // proxies before this index are sorted by min.x; later ones were just added
+  size_t sorted_count;
+  // the widest sorted proxy, which bounds how far back a query must look
+  double max_width;
+  list_t *rules;
+  pair_t **buckets;
+  size_t bucket_count;
+  size_t pair_count;
+  size_t stamp;
+  trigger_event_t *events;
+  size_t event_count;
+  size_t event_capacity;
+} broadphase_t;
+
+void rule_free(rule_t *rule) {
+  if (rule->freer != NULL) {
+    rule->freer(rule->aux);
+  }
+  free(rule);
+}
+
+void pair_free(pair_t *pair) {
+  if (pair->contact != NULL) {
+    contact_free(pair->contact);
+  }
+  free(pair);
+}
+
+pair_t **broadphase_alloc_buckets(size_t count) {
+  pair_t **buckets = calloc(count, sizeof(pair_t *));
+  assert(buckets != NULL);
+  return buckets;
+}
+
+broadphase_t *broadphase_init(void) {
+  broadphase_t *bp = malloc(sizeof(broadphase_t));
+  assert(bp != NULL);
+  bp->proxy_capacity = INIT_PROXIES_CAPACITY;
+  bp->proxies = malloc(sizeof(proxy_t) * bp->proxy_capacity);
+  assert(bp->proxies != NULL);
+  bp->proxy_count = 0;
+  bp->sorted_count = 0;
+  bp->max_width = 0;
+  bp->rules = list_init(INIT_RULES_SIZE, (free_func_t)rule_free);
+  bp->bucket_count = INIT_BUCKET_COUNT;
+  bp->buckets = broadphase_alloc_buckets(bp->bucket_count);
+  bp->pair_count = 0;
+  bp->stamp = 0;
+  bp->event_capacity = INIT_EVENTS_CAPACITY;
+  bp->events = malloc(sizeof(trigger_event_t) * bp->event_capacity);
+  assert(bp->events != NULL);
+  bp->event_count = 0;
+  return bp;
+}
+
+void broadphase_free(broadphase_t *bp) {
+  for (size_t i = 0; i < bp->bucket_count; i++) {
+    pair_t *pair = bp->buckets[i];
+    while (pair != NULL) {
+      pair_t *next = pair->next;
+      pair_free(pair);
+      pair = next;
+    }
+  }
+  free(bp->buckets);
+  list_free(bp->rules);
+  free(bp->proxies);
+  free(bp->events);
+  free(bp);
+}
+
+void broadphase_add_rule(broadphase_t *bp, uint32_t category1,
+                         uint32_t category2, double elasticity,
+                         collision_handler_t handler, void *aux,
+                         free_func_t freer) {
+  rule_t *rule = malloc(sizeof(rule_t));
+  assert(rule != NULL);
+  rule->category1 = category1;
+  rule->category2 = category2;
+  rule->elasticity = elasticity;
+  rule->handler = handler;
+  rule->aux = aux;
+  rule->freer = freer;
+  list_add(bp->rules, rule);
+}
+
+void broadphase_add_body(broadphase_t *bp, body_t *body) {
+  if (bp->proxy_count == bp->proxy_capacity) {
+    bp->proxy_capacity *= 2;
+    bp->proxies = realloc(bp->proxies, sizeof(proxy_t) * bp->proxy_capacity);
+    assert(bp->proxies != NULL);
+  }
+  // new bodies start at the end; the next sort moves them into place
+  bp->proxies[bp->proxy_count].body = body;
+  bp->proxies[bp->proxy_count].bounds = body_get_bounds(body);
+  bp->proxy_count++;
+}
+
+/** Hashes an unordered pair of bodies */
+size_t broadphase_hash(broadphase_t *bp, body_t *body1, body_t *body2) {
+  uintptr_t a = (uintptr_t)body1;
+  uintptr_t b = (uintptr_t)body2;
+  if (a > b) {
+    uintptr_t temp = a;
+    a = b;
+    b = temp;
+  }
+  // bodies are heap-allocated, so the low bits carry no information
+  uintptr_t hash = (a >> 4) * 31 + (b >> 4);
+  return hash % bp->bucket_count;
+}
+
+bool pair_has_bodies(pair_t *pair, body_t *body1, body_t *body2) {
+  return (pair->body1 == body1 && pair->body2 == body2) ||
+         (pair->body1 == body2 && pair->body2 == body1);
+}
+
+pair_t *broadphase_find_pair(broadphase_t *bp, body_t *body1, body_t *body2) {
+  pair_t *pair = bp->buckets[broadphase_hash(bp, body1, body2)];
+  while (pair != NULL && !pair_has_bodies(pair, body1, body2)) {
+    pair = pair->next;
+  }
+  return pair;
+}
+
+void broadphase_rehash(broadphase_t *bp) {
+  pair_t **old_buckets = bp->buckets;
+  size_t old_count = bp->bucket_count;
+  bp->bucket_count *= 2;
+  bp->buckets = broadphase_alloc_buckets(bp->bucket_count);
+  for (size_t i = 0; i < old_count; i++) {
+    pair_t *pair = old_buckets[i];
+    while (pair != NULL) {
+      pair_t *next = pair->next;
+      size_t bucket = broadphase_hash(bp, pair->body1, pair->body2);
+      pair->next = bp->buckets[bucket];
+      bp->buckets[bucket] = pair;
+      pair = next;
+    }
+  }
+  free(old_buckets);
+}
+
+/**
+ * Finds the first rule matching two bodies' categories.
+ * Sets swapped if body2 has to be passed to the rule first.
+ */
+rule_t *broadphase_find_rule(broadphase_t *bp, body_t *body1, body_t *body2,
+                             bool *swapped) {
+  uint32_t category1 = body_get_category(body1);
+  uint32_t category2 = body_get_category(body2);
+  for (size_t i = 0; i < list_size(bp->rules); i++) {
+    rule_t *rule = list_get(bp->rules, i);
+    if ((rule->category1 & category1) && (rule->category2 & category2)) {
+      *swapped = false;
+      return rule;
+    }
+    if ((rule->category1 & category2) && (rule->category2 & category1)) {
+      *swapped = true;
+      return rule;
+    }
+  }
+  return NULL;
+}
+
+pair_t *broadphase_add_pair(broadphase_t *bp, body_t *body1, body_t *body2,
+                            rule_t *rule) {
+  if (bp->pair_count >= bp->bucket_count * MAX_LOAD_FACTOR) {
+    broadphase_rehash(bp);
+  }
+  pair_t *pair = malloc(sizeof(pair_t));
+  assert(pair != NULL);
+  pair->body1 = body1;
+  pair->body2 = body2;
+  pair->rule = rule;
+  pair->contact = rule != NULL && rule->handler == NULL
+                      ? contact_init(body1, body2, rule->elasticity)
+                      : NULL;
+  pair->cache = collision_cache_init();
+  pair->touching = false;
+  size_t bucket = broadphase_hash(bp, body1, body2);
+  pair->next = bp->buckets[bucket];
+  bp->buckets[bucket] = pair;
+  bp->pair_count++;
+  return pair;
+}
+
+void broadphase_add_event(broadphase_t *bp, pair_t *pair, bool begin) {
+  if (bp->event_count == bp->event_capacity) {
+    bp->event_capacity *= 2;
+    bp->events =
+        realloc(bp->events, sizeof(trigger_event_t) * bp->event_capacity);
+    assert(bp->events != NULL);
+  }
+  bp->events[bp->event_count] = (trigger_event_t){
+      .sensor = pair->body1, .other = pair->body2, .begin = begin};
+  bp->event_count++;
+}
+
+/**
+ * Frees every pair that matches, unlinking it from its bucket.
+ * Stale sensor pairs that were touching report their end event;
+ * pairs dropped for a removed body don't, since it is about to be freed.
+ */
+void broadphase_remove_pairs(broadphase_t *bp, body_t *body, bool stale) {
+  for (size_t i = 0; i < bp->bucket_count; i++) {
+    pair_t **link = &bp->buckets[i];
+    while (*link != NULL) {
+      pair_t *pair = *link;
+      bool remove = stale ? pair->stamp != bp->stamp
+                          : pair->body1 == body || pair->body2 == body;
+      if (remove) {
+        if (stale && pair->rule == NULL && pair->touching) {
+          broadphase_add_event(bp, pair, false);
+        }
+        *link = pair->next;
+        pair_free(pair);
+        bp->pair_count--;
+      } else {
+        link = &pair->next;
+      }
+    }
+  }
+}
+
+void broadphase_remove_body(broadphase_t *bp, body_t *body) {
+  for (size_t i = 0; i < bp->proxy_count; i++) {
+    if (bp->proxies[i].body == body) {
+      for (size_t j = i + 1; j < bp->proxy_count; j++) {
+        bp->proxies[j - 1] = bp->proxies[j];
+      }
+      bp->proxy_count--;
+      if (i < bp->sorted_count) {
+        bp->sorted_count--;
+      }
+      break;
+    }
+  }
+  broadphase_remove_pairs(bp, body, false);
+  size_t kept = 0;
+  for (size_t i = 0; i < bp->event_count; i++) {
+    if (bp->events[i].sensor != body && bp->events[i].other != body) {
+      bp->events[kept++] = bp->events[i];
+    }
+  }
+  bp->event_count = kept;
+}
+
+bool broadphase_filters_match(body_t *body1, body_t *body2) {
+  return (body_get_category(body1) & body_get_mask(body2)) &&
+         (body_get_category(body2) & body_get_mask(body1));
+}
+
+/** Runs the narrow phase for a pair whose bounding boxes overlap */
+void broadphase_collide(broadphase_t *bp, pair_t *pair, solver_t *solver) {
+  if (pair->contact != NULL) {
+    if (contact_update(pair->contact)) {
+      solver_add_contact(solver, pair->contact);
+    }
+    return;
+  }
+  collision_info_t info =
+      body_find_collision(pair->body1, pair->body2, &pair->cache);
+  if (pair->rule == NULL) {
+    if (info.collided != pair->touching) {
+      broadphase_add_event(bp, pair, info.collided);
+    }
+  } else if (info.collided && !pair->touching) {
+    pair->rule->handler(pair->body1, pair->body2, info.axis, pair->rule->aux);
+  }
+  pair->touching = info.collided;
+}
+
+/**
+ * Checks the proxies at two indices of the sorted array.
+ * Takes indices because a handler may add bodies, moving the array.
+ */
+void broadphase_check(broadphase_t *bp, size_t index1, size_t index2,
+                      solver_t *solver) {
+  proxy_t *proxy1 = &bp->proxies[index1];
+  proxy_t *proxy2 = &bp->proxies[index2];
+  body_t *body1 = proxy1->body;
+  body_t *body2 = proxy2->body;
+  if (!broadphase_filters_match(body1, body2)) {
+    return;
+  }
+  if (proxy1->bounds.min.y > proxy2->bounds.max.y ||
+      proxy2->bounds.min.y > proxy1->bounds.max.y) {
+    return;
+  }
+  pair_t *pair = broadphase_find_pair(bp, body1, body2);
+  if (pair == NULL && body_is_sensor(body1)) {
+    pair = broadphase_add_pair(bp, body1, body2, NULL);
+  } else if (pair == NULL && body_is_sensor(body2)) {
+    pair = broadphase_add_pair(bp, body2, body1, NULL);
+  } else if (pair == NULL) {
+    bool swapped;
+    rule_t *rule = broadphase_find_rule(bp, body1, body2, &swapped);
+    if (rule == NULL) {
+      return;
+    }
+    pair = swapped ? broadphase_add_pair(bp, body2, body1, rule)
+                   : broadphase_add_pair(bp, body1, body2, rule);
+  }
+  pair->stamp = bp->stamp;
+  // neither body has moved, so whatever was touching still is
+  if (body_is_sleeping(body1) && body_is_sleeping(body2)) {
+    return;
+  }
+  broadphase_collide(bp, pair, solver);
+}
+
+void broadphase_refresh(broadphase_t *bp) {
+  bp->max_width = 0;
+  for (size_t i = 0; i < bp->proxy_count; i++) {
+    proxy_t *proxy = &bp->proxies[i];
+    if (!body_is_sleeping(proxy->body)) {
+      proxy->bounds = body_get_bounds(proxy->body);
+    }
+    double width = proxy->bounds.max.x - proxy->bounds.min.x;
+    if (width > bp->max_width) {
+      bp->max_width = width;
+    }
+  }
+
+  for (size_t i = 1; i < bp->proxy_count; i++) {
+    proxy_t curr = bp->proxies[i];
+    size_t j = i;
+    while (j > 0 && bp->proxies[j - 1].bounds.min.x > curr.bounds.min.x) {
+      bp->proxies[j] = bp->proxies[j - 1];
+      j--;
+    }
+    bp->proxies[j] = curr;
+  }
+  bp->sorted_count = bp->proxy_count;
+}
+
+void broadphase_update(broadphase_t *bp, solver_t *solver) {
+  bp->stamp++;
+  broadphase_refresh(bp);
+
+  for (size_t i = 0; i < bp->proxy_count; i++) {
+    if (body_get_category(bp->proxies[i].body) == 0) {
+      continue;
+    }
+    for (size_t j = i + 1;
+         j < bp->proxy_count &&
+         bp->proxies[j].bounds.min.x <= bp->proxies[i].bounds.max.x;
+         j++) {
+      broadphase_check(bp, i, j, solver);
+    }
+  }
+
+  // pairs whose boxes no longer overlap can't be touching
+  broadphase_remove_pairs(bp, NULL, true);
+}
+
+bool broadphase_interacts(broadphase_t *bp, body_t *body1, body_t *body2) {
+  if (!broadphase_filters_match(body1, body2)) {
+    return false;
+  }
+  if (body_is_sensor(body1) || body_is_sensor(body2)) {
+    return true;
+  }
+  bool swapped;
+  return broadphase_find_rule(bp, body1, body2, &swapped) != NULL;
+}
+
+void broadphase_impact(broadphase_t *bp, body_t *body1, body_t *body2,
+                       vector_t axis) {
+  if (body_is_sensor(body1) || body_is_sensor(body2)) {
+    // keep the pair like a stepped tick would, so neither mode reports
+    // the overlap twice
+    pair_t *pair = broadphase_find_pair(bp, body1, body2);
+    if (pair == NULL) {
+      pair = body_is_sensor(body1)
+                 ? broadphase_add_pair(bp, body1, body2, NULL)
+                 : broadphase_add_pair(bp, body2, body1, NULL);
+    }
+    pair->stamp = bp->stamp;
+    if (!pair->touching) {
+      pair->touching = true;
+      broadphase_add_event(bp, pair, true);
+    }
+    return;
+  }
+  bool swapped;
+  rule_t *rule = broadphase_find_rule(bp, body1, body2, &swapped);
+  if (rule == NULL) {
+    return;
+  }
+  if (rule->handler != NULL) {
+    if (swapped) {
+      rule->handler(body2, body1, vec_negate(axis), rule->aux);
+    } else {
+      rule->handler(body1, body2, axis, rule->aux);
+    }
+    return;
+  }
+  double inv_mass1 = body_get_inverse_mass(body1);
+  double inv_mass2 = body_get_inverse_mass(body2);
+  double approach = vec_dot(
+      vec_subtract(body_get_velocity(body2), body_get_velocity(body1)), axis);
+  if (inv_mass1 + inv_mass2 == 0 || approach >= 0) {
+    return;
+  }
+  double impulse =
+      -(1 + rule->elasticity) * approach / (inv_mass1 + inv_mass2);
+  body_set_velocity(body1, vec_subtract(body_get_velocity(body1),
+                                        vec_multiply(impulse * inv_mass1,
+                                                     axis)));
+  body_set_velocity(body2, vec_add(body_get_velocity(body2),
+                                   vec_multiply(impulse * inv_mass2, axis)));
+}
+
+void broadphase_separate(broadphase_t *bp, body_t *body1, body_t *body2) {
+  pair_t *pair = broadphase_find_pair(bp, body1, body2);
+  if (pair == NULL || pair->rule != NULL) {
+    return;
+  }
+  if (pair->touching) {
+    broadphase_add_event(bp, pair, false);
+  }
+  size_t bucket = broadphase_hash(bp, body1, body2);
+  pair_t **link = &bp->buckets[bucket];
+  while (*link != pair) {
+    link = &(*link)->next;
+  }
+  *link = pair->next;
+  pair_free(pair);
+  bp->pair_count--;
+}
+
+void broadphase_clear_events(broadphase_t *bp) { bp->event_count = 0; }
+
+size_t broadphase_events(broadphase_t *bp) { return bp->event_count; }
+
+trigger_event_t broadphase_get_event(broadphase_t *bp, size_t index) {
+  assert(index < bp->event_count);
+  return bp->events[index];
+}
+
+size_t broadphase_pairs(broadphase_t *bp) { return bp->pair_count; }
+
+/**
+ * Finds the first sorted proxy whose min.x is above x,
+ * or at least x if inclusive is set.
+ */
+size_t broadphase_search(broadphase_t *bp, double x, bool inclusive) {
+  size_t low = 0;
+  size_t high = bp->sorted_count;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    double min_x = bp->proxies[mid].bounds.min.x;
+    if (inclusive ? min_x < x : min_x <= x) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+void broadphase_query(broadphase_t *bp, aabb_t box, broadphase_query_t callback,
+                      void *aux) {
+  // no sorted proxy starting further left than this can reach the box
+  size_t start = broadphase_search(bp, box.min.x - bp->max_width, true);
+  size_t end = broadphase_search(bp, box.max.x, false);
+  for (size_t i = start; i < end; i++) {
+    if (aabb_overlap(bp->proxies[i].bounds, box) &&
+        !callback(bp->proxies[i].body, aux)) {
+      return;
+    }
+  }
+  for (size_t i = bp->sorted_count; i < bp->proxy_count; i++) {
+    if (aabb_overlap(bp->proxies[i].bounds, box) &&
+        !callback(bp->proxies[i].body, aux)) {
+      return;
+    }
+  }
+}
@@ -7,25 +7,75 @@
 #include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_ttf.h>
+#include <assert.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-const size_t INIT_EDGES_CAPACITY = 5;
+// SAT costs O((n+m)^2) per pair; beyond this many vertices GJK/EPA is cheaper
+static const size_t GJK_VERTEX_THRESHOLD = 24;
+static const size_t GJK_MAX_ITERATIONS = 32;
+#define EPA_MAX_ITERATIONS 32
+// EPA stops once a new support point improves the depth by less than this
+static const double EPA_TOLERANCE = 1e-6;
 
-list_t *right_edges(list_t *shape) {
+/**
+ * Computes the outward normal of one edge of the two shapes; the edges of
+ * shape1 come first, then those of shape2.
+ */
+vector_t sat_axis(polygon_view_t shape1, polygon_view_t shape2,
+                  size_t index) {
+  polygon_view_t shape = shape1;
+  if (index >= shape1.size) {
+    index -= shape1.size;
+    shape = shape2;
+  }
+  vector_t vec1 = shape.points[(index + 1) % shape.size];
+  vector_t vec2 = shape.points[index];
+  return vec_normalize(vec_rotate(vec_subtract(vec1, vec2), M_PI / 2.0));
+}
+
+/** Projects a shape onto an axis, as the interval {min, max} */
+vector_t view_projection(vector_t axis, polygon_view_t shape) {
+  double min = INFINITY;
+  double max = -INFINITY;
+  for (size_t i = 0; i < shape.size; i++) {
+    double vertex_proj = vec_dot(axis, shape.points[i]);
+    if (vertex_proj > max) {
+      max = vertex_proj;
+    }
+    if (vertex_proj < min) {
+      min = vertex_proj;
+    }
+  }
+  return (vector_t){min, max};
+}
+
+/** Returns whether the shapes' projections onto an axis are disjoint */
+bool sat_separates(polygon_view_t shape1, polygon_view_t shape2,
+                   vector_t axis) {
+  return !vec_interval_overlap(view_projection(axis, shape1),
+                               view_projection(axis, shape2));
+}
+
+/**
+ * Copies the vertices of a list into an array, for the functions below.
+ * The array must be free()d.
+ */
+polygon_view_t view_from_list(list_t *shape) {
   size_t size = list_size(shape);
-  list_t *edges = list_init(size - 1, (free_func_t)free);
+  vector_t *points = malloc(sizeof(vector_t) * size);
+  assert(points != NULL);
   for (size_t i = 0; i < size; i++) {
-    vector_t *vec1 = list_get(shape, (i + 1) % size);
-    vector_t *vec2 = list_get(shape, i);
-    vector_t *one_edge = malloc(sizeof(vector_t));
-    *one_edge =
-        vec_normalize(vec_rotate(vec_subtract(*vec1, *vec2), M_PI / 2.0));
-    list_add(edges, one_edge);
-  }
-  return edges;
+    points[i] = *(vector_t *)list_get(shape, i);
+  }
+  return (polygon_view_t){.points = points, .size = size};
+}
+
+collision_cache_t collision_cache_init(void) {
+  return (collision_cache_t){.axis_index = SIZE_MAX, .direction = VEC_ZERO};
 }
 
 vector_t shape_projection(vector_t *axis, list_t *shape) {
@@ -44,33 +94,249 @@ vector_t shape_projection(vector_t *axis, list_t *shape) {
   return (vector_t){min, max};
 }
 
-collision_info_t find_collision(list_t *shape1, list_t *shape2) {
+collision_info_t find_collision_sat(polygon_view_t shape1,
+                                    polygon_view_t shape2,
+                                    collision_cache_t *cache) {
   collision_info_t result;
-
-  list_t *tot_edges = list_init(INIT_EDGES_CAPACITY, (free_func_t)free);
-  list_append(tot_edges, right_edges(shape1));
-  list_append(tot_edges, right_edges(shape2));
+  result.collided = false;
+  size_t axis_count = shape1.size + shape2.size;
+  // the pair is most likely still separated along the same axis
+  if (cache != NULL && cache->axis_index < axis_count &&
+      sat_separates(shape1, shape2,
+                    sat_axis(shape1, shape2, cache->axis_index))) {
+    return result;
+  }
 
   double min_overlap = INFINITY;
-  int min_idx = -1;
-  for (size_t i = 0; i < list_size(tot_edges); i++) {
-    vector_t *curr_axis = (vector_t *)list_get(tot_edges, i);
-    vector_t v1 = shape_projection(curr_axis, shape1);
-    vector_t v2 = shape_projection(curr_axis, shape2);
+  vector_t min_axis = VEC_ZERO;
+  bool flip = false;
+  for (size_t i = 0; i < axis_count; i++) {
+    vector_t curr_axis = sat_axis(shape1, shape2, i);
+    vector_t v1 = view_projection(curr_axis, shape1);
+    vector_t v2 = view_projection(curr_axis, shape2);
     if (!vec_interval_overlap(v1, v2)) {
-      result.collided = false;
-      list_free(tot_edges);
+      if (cache != NULL) {
+        cache->axis_index = i;
+      }
       return result;
     } else {
-      double overlap = vec_overlap(v1, v2);
+      // how far shape2 must move forwards or backwards along the axis to
+      // clear shape1; vec_overlap() only measures one side, which is too
+      // deep when one projection contains the other
+      double forwards = v1.y - v2.x;
+      double backwards = v2.y - v1.x;
+      double overlap = fmin(forwards, backwards);
       if (overlap < min_overlap) {
         min_overlap = overlap;
-        min_idx = i;
+        min_axis = curr_axis;
+        // point the axis from shape1 towards shape2
+        flip = backwards < forwards;
       }
     }
   }
   result.collided = true;
-  result.axis = *((vector_t *)list_get(tot_edges, min_idx));
-  list_free(tot_edges);
+  result.axis = flip ? vec_negate(min_axis) : min_axis;
+  result.depth = min_overlap;
   return result;
 }
+
+/** Finds the vertex of a shape furthest along a direction */
+vector_t gjk_support_shape(polygon_view_t shape, vector_t dir) {
+  vector_t best = shape.points[0];
+  double best_proj = vec_dot(best, dir);
+  for (size_t i = 1; i < shape.size; i++) {
+    vector_t vertex = shape.points[i];
+    double proj = vec_dot(vertex, dir);
+    if (proj > best_proj) {
+      best = vertex;
+      best_proj = proj;
+    }
+  }
+  return best;
+}
+
+/**
+ * Finds the point of the Minkowski difference shape2 - shape1
+ * furthest along a direction. The shapes overlap iff it contains the origin.
+ */
+vector_t gjk_support(polygon_view_t shape1, polygon_view_t shape2,
+                     vector_t dir) {
+  return vec_subtract(gjk_support_shape(shape2, dir),
+                      gjk_support_shape(shape1, vec_negate(dir)));
+}
+
+/** Returns a vector perpendicular to v, on the side of toward */
+vector_t gjk_perpendicular(vector_t v, vector_t toward) {
+  vector_t perp = {-v.y, v.x};
+  return vec_dot(perp, toward) < 0 ? vec_negate(perp) : perp;
+}
+
+/**
+ * Reduces the simplex to the feature closest to the origin and sets the next
+ * search direction towards the origin.
+ * Returns whether the simplex encloses (or touches) the origin.
+ */
+bool gjk_evolve(vector_t *simplex, size_t *size, vector_t *dir) {
+  vector_t a = simplex[*size - 1];
+  vector_t ao = vec_negate(a);
+  if (*size == 2) {
+    vector_t ab = vec_subtract(simplex[0], a);
+    if (vec_dot(ab, ao) > 0) {
+      *dir = gjk_perpendicular(ab, ao);
+      // the origin lies on the segment
+      return vec_dot(*dir, ao) == 0;
+    }
+    simplex[0] = a;
+    *size = 1;
+    *dir = ao;
+    return false;
+  }
+  vector_t b = simplex[1];
+  vector_t c = simplex[0];
+  vector_t ab = vec_subtract(b, a);
+  vector_t ac = vec_subtract(c, a);
+  vector_t ab_out = gjk_perpendicular(ab, vec_negate(ac));
+  vector_t ac_out = gjk_perpendicular(ac, vec_negate(ab));
+  if (vec_dot(ab_out, ao) > 0) {
+    simplex[0] = b;
+    simplex[1] = a;
+    *size = 2;
+    *dir = ab_out;
+    return false;
+  }
+  if (vec_dot(ac_out, ao) > 0) {
+    simplex[1] = a;
+    *size = 2;
+    *dir = ac_out;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Expands a triangle of the Minkowski difference enclosing the origin until
+ * its edge closest to the origin is on the difference's boundary.
+ * That edge's outward normal and distance are the penetration.
+ */
+collision_info_t epa_penetration(polygon_view_t shape1, polygon_view_t shape2,
+                                 vector_t *triangle) {
+  vector_t polytope[3 + EPA_MAX_ITERATIONS];
+  size_t size = 3;
+  polytope[0] = triangle[0];
+  polytope[1] = triangle[1];
+  polytope[2] = triangle[2];
+  // wind counterclockwise so (e.y, -e.x) is each edge's outward normal
+  if (vec_cross(vec_subtract(polytope[1], polytope[0]),
+                vec_subtract(polytope[2], polytope[0])) < 0) {
+    polytope[1] = triangle[2];
+    polytope[2] = triangle[1];
+  }
+  collision_info_t result = {.collided = true};
+  for (size_t iter = 0; iter <= EPA_MAX_ITERATIONS; iter++) {
+    size_t closest = 0;
+    double min_dist = INFINITY;
+    vector_t normal = VEC_ZERO;
+    for (size_t i = 0; i < size; i++) {
+      vector_t edge = vec_subtract(polytope[(i + 1) % size], polytope[i]);
+      if (edge.x == 0 && edge.y == 0) {
+        continue;
+      }
+      vector_t n = vec_normalize((vector_t){edge.y, -edge.x});
+      double dist = vec_dot(n, polytope[i]);
+      if (dist < min_dist) {
+        min_dist = dist;
+        normal = n;
+        closest = i;
+      }
+    }
+    // moving shape1 by depth along the normal separates the shapes
+    result.axis = vec_negate(normal);
+    result.depth = fmax(min_dist, 0);
+    vector_t support = gjk_support(shape1, shape2, normal);
+    if (iter == EPA_MAX_ITERATIONS ||
+        vec_dot(support, normal) - min_dist < EPA_TOLERANCE) {
+      return result;
+    }
+    for (size_t i = size; i > closest + 1; i--) {
+      polytope[i] = polytope[i - 1];
+    }
+    polytope[closest + 1] = support;
+    size++;
+  }
+  return result;
+}
+
+collision_info_t find_collision_gjk(polygon_view_t shape1,
+                                    polygon_view_t shape2,
+                                    collision_cache_t *cache) {
+  collision_info_t result = {.collided = false};
+  vector_t simplex[3];
+  size_t size = 0;
+  vector_t dir = vec_subtract(shape2.points[0], shape1.points[0]);
+  if (cache != NULL && (cache->direction.x != 0 || cache->direction.y != 0)) {
+    // start from the direction that separated the shapes last time
+    dir = cache->direction;
+  }
+  if (dir.x == 0 && dir.y == 0) {
+    dir = (vector_t){1, 0};
+  }
+  simplex[size++] = gjk_support(shape1, shape2, dir);
+  if (vec_dot(simplex[0], dir) < 0) {
+    // the whole difference lies behind dir, so it misses the origin
+    return result;
+  }
+  dir = vec_negate(simplex[0]);
+  for (size_t iter = 0; iter < GJK_MAX_ITERATIONS; iter++) {
+    if (dir.x == 0 && dir.y == 0) {
+      // the origin is a vertex of the difference: the shapes just touch
+      break;
+    }
+    vector_t point = gjk_support(shape1, shape2, dir);
+    if (vec_dot(point, dir) < 0) {
+      if (cache != NULL) {
+        cache->direction = dir;
+      }
+      return result;
+    }
+    simplex[size++] = point;
+    if (gjk_evolve(simplex, &size, &dir)) {
+      break;
+    }
+  }
+  while (size < 3) {
+    // touching contacts leave a degenerate simplex; widen it to a triangle
+    vector_t base = size == 1 ? (vector_t){1, 0}
+                              : gjk_perpendicular(
+                                    vec_subtract(simplex[1], simplex[0]),
+                                    (vector_t){1, 0});
+    if (base.x == 0 && base.y == 0) {
+      base = (vector_t){0, 1};
+    }
+    vector_t point = gjk_support(shape1, shape2, base);
+    if (size == 2 && vec_cross(vec_subtract(simplex[1], simplex[0]),
+                               vec_subtract(point, simplex[0])) == 0) {
+      point = gjk_support(shape1, shape2, vec_negate(base));
+    }
+    simplex[size++] = point;
+  }
+  return epa_penetration(shape1, shape2, simplex);
+}
+
+collision_info_t find_collision_view(polygon_view_t shape1,
+                                     polygon_view_t shape2,
+                                     collision_cache_t *cache) {
+  if (shape1.size + shape2.size > GJK_VERTEX_THRESHOLD) {
+    return find_collision_gjk(shape1, shape2, cache);
+  }
+  return find_collision_sat(shape1, shape2, cache);
+}
+
+collision_info_t find_collision(list_t *shape1, list_t *shape2,
+                                collision_cache_t *cache) {
+  polygon_view_t view1 = view_from_list(shape1);
+  polygon_view_t view2 = view_from_list(shape2);
+  collision_info_t info = find_collision_view(view1, view2, cache);
+  free((vector_t *)view1.points);
+  free((vector_t *)view2.points);
+  return info;
+}
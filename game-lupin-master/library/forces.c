@@ -4,6 +4,7 @@
 #include "list.h"
 #include "polygon.h"
 #include "scene.h"
+#include "solver.h"
 #include "vector.h"
 #include <assert.h>
 #include <math.h>
@@ -37,9 +38,15 @@ typedef struct collision_aux {
   free_func_t freer;
   body_t *body1;
   body_t *body2;
+  collision_cache_t cache;
   bool previously_colliding;
 } collision_aux_t;
 
+typedef struct physics_aux {
+  scene_t *scene;
+  contact_t *contact;
+} physics_aux_t;
+
 void aux_free(aux_t *aux) {
   if (aux->bodies != NULL) {
     list_free(aux->bodies);
@@ -49,11 +56,16 @@ void aux_free(aux_t *aux) {
 
 void collision_aux_free(collision_aux_t *aux) {
   if (aux->freer != NULL) {
-    aux->freer(aux);
+    aux->freer(aux->aux);
   }
   free(aux);
 }
 
+void physics_aux_free(physics_aux_t *aux) {
+  contact_free(aux->contact);
+  free(aux);
+}
+
 aux_t *aux_init_two_bodies(double constant, body_t *body1, body_t *body2) {
   aux_t *param = malloc(sizeof(aux_t));
   assert(param != NULL);
@@ -113,6 +125,17 @@ bool force_is_body_in_force(force_t *force, body_t *body) {
   return list_contains(force->bodies, body);
 }
 
+bool force_links_bodies(force_t *force) {
+  return force->bodies != NULL &&
+         force->force_c != (force_creator_t)collision_force_creator &&
+         force->force_c != (force_creator_t)physics_collision_force_creator;
+}
+
+bool force_is_field(force_t *force) {
+  return force->force_c == (force_creator_t)newtonian_force ||
+         force->force_c == (force_creator_t)spring_force;
+}
+
 void apply_force_creator(force_t *force) { force->force_c(force->aux); }
 
 void newtonian_force(aux_t *aux_val) {
@@ -165,31 +188,6 @@ void apply_impulse(body_t *target, body_t *other, double coeff, vector_t axis) {
   body_add_impulse(target, impulse);
 }
 
-void comp_impulse(body_t *body1, body_t *body2, vector_t axis, void *aux) {
-  double Cr = ((elast_t *)aux)->e_value;
-  double m1 = body_get_mass(body1);
-  double m2 = body_get_mass(body2);
-  double u1 = vec_dot(axis, body_get_velocity(body1));
-  double u2 = vec_dot(axis, body_get_velocity(body2));
-  double coeff;
-  vector_t impulse;
-  // from notes on spec
-  if (m1 == INFINITY) {
-    coeff = m2 * (1.0 + Cr) * (u2 - u1);
-    impulse = vec_multiply(-coeff, axis);
-    body_add_impulse(body2, impulse);
-  } else if (m2 == INFINITY) {
-    coeff = m1 * (1.0 + Cr) * (u2 - u1);
-    impulse = vec_multiply(coeff, axis);
-    body_add_impulse(body1, impulse);
-  } else {
-    coeff = (m1 * m2) / (m1 + m2) * (1.0 + Cr) * (u2 - u1) + 0.01;
-    impulse = vec_multiply(coeff, axis);
-    body_add_impulse(body1, impulse);
-    body_add_impulse(body2, vec_negate(impulse));
-  }
-}
-
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
                               body_t *body2) {
   list_t *bodies = list_init(BODIES_INIT_SIZE, NULL);
@@ -210,11 +208,7 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
 }
 
 void create_drag(scene_t *scene, double gamma, body_t *body) {
-  list_t *bodies = list_init(1, NULL);
-  list_add(bodies, body);
-  scene_add_bodies_force_creator(scene, (force_creator_t)drag_force,
-                                 aux_init_one_body(gamma, body), bodies,
-                                 (free_func_t)aux_free);
+  body_set_drag(body, body_get_drag(body) + gamma);
 }
 
 void create_collision(scene_t *scene, body_t *body1, body_t *body2,
@@ -226,6 +220,7 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
   col_aux->freer = freer;
   col_aux->body1 = body1;
   col_aux->body2 = body2;
+  col_aux->cache = collision_cache_init();
   col_aux->previously_colliding = false;
 
   list_t *bodies = list_init(BODIES_INIT_SIZE, NULL);
@@ -245,25 +240,41 @@ void create_destructive_collision(scene_t *scene, body_t *body1,
 
 void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
                               body_t *body2) {
-  elast_t *elast = malloc(sizeof(elast_t));
-  elast->e_value = elasticity;
-  create_collision(scene, body1, body2, (collision_handler_t)comp_impulse,
-                   elast, free);
+  physics_aux_t *aux = malloc(sizeof(physics_aux_t));
+  assert(aux != NULL);
+  aux->scene = scene;
+  aux->contact = contact_init(body1, body2, elasticity);
+
+  list_t *bodies = list_init(BODIES_INIT_SIZE, NULL);
+  list_add(bodies, body1);
+  list_add(bodies, body2);
+  scene_add_bodies_force_creator(scene,
+                                 (force_creator_t)physics_collision_force_creator,
+                                 aux, bodies, (free_func_t)physics_aux_free);
 }
 
 void collision_force_creator(collision_aux_t *other_aux) {
   body_t *body1 = other_aux->body1;
   body_t *body2 = other_aux->body2;
+  // neither body has moved, so whatever was touching still is
+  if (body_is_sleeping(body1) && body_is_sleeping(body2)) {
+    return;
+  }
 
-  list_t *shape1 = body_get_shape(body1);
-  list_t *shape2 = body_get_shape(body2);
-
-  collision_info_t info = find_collision(shape1, shape2);
-  list_free(shape1);
-  list_free(shape2);
+  collision_info_t info = body_find_collision(body1, body2, &other_aux->cache);
 
   if (info.collided && !other_aux->previously_colliding) {
     other_aux->handler(body1, body2, info.axis, other_aux->aux);
   }
   other_aux->previously_colliding = info.collided;
-}
\ No newline at end of file
+}
+
+void physics_collision_force_creator(physics_aux_t *aux) {
+  if (body_is_sleeping(contact_get_body1(aux->contact)) &&
+      body_is_sleeping(contact_get_body2(aux->contact))) {
+    return;
+  }
+  if (contact_update(aux->contact)) {
+    solver_add_contact(scene_get_solver(aux->scene), aux->contact);
+  }
+}
@@ -0,0 +1,143 @@
+#include "glyph_atlas.h"
+#include "quad_batch.h"
+#include "vector.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <assert.h>
+#include <stdlib.h>
+
+static const SDL_Color GLYPH_COLOR = (SDL_Color){255, 255, 255, 255};
+// The atlas holds the printable ASCII characters
+static const char FIRST_GLYPH = ' ';
+static const char LAST_GLYPH = '~';
+static const char MISSING_GLYPH = '?';
+static const int ATLAS_WIDTH = 512;
+// Blank pixels between glyphs, so filtering never bleeds into neighbours
+static const int GLYPH_PADDING = 1;
+
+typedef struct glyph {
+  SDL_Rect src;
+  int advance;
+} glyph_t;
+
+typedef struct glyph_atlas {
+  SDL_Texture *texture;
+  int width;
+  int height;
+  glyph_t *glyphs;
+  quad_batch_t *batch;
+} glyph_atlas_t;
+
+glyph_atlas_t *glyph_atlas_init(SDL_Renderer *renderer, TTF_Font *font) {
+  glyph_atlas_t *atlas = malloc(sizeof(glyph_atlas_t));
+  assert(atlas != NULL);
+  size_t count = LAST_GLYPH - FIRST_GLYPH + 1;
+  atlas->glyphs = malloc(sizeof(glyph_t) * count);
+  assert(atlas->glyphs != NULL);
+  SDL_Surface **surfaces = malloc(sizeof(SDL_Surface *) * count);
+  assert(surfaces != NULL);
+
+  // Lay the glyphs out in rows, left to right
+  int x = 0, y = 0, row_height = 0;
+  for (size_t i = 0; i < count; i++) {
+    char c = FIRST_GLYPH + i;
+    glyph_t *glyph = &atlas->glyphs[i];
+    glyph->src = (SDL_Rect){0, 0, 0, 0};
+    glyph->advance = 0;
+    surfaces[i] = NULL;
+    if (!TTF_GlyphIsProvided(font, c)) {
+      continue;
+    }
+    TTF_GlyphMetrics(font, c, NULL, NULL, NULL, NULL, &glyph->advance);
+    surfaces[i] = TTF_RenderGlyph_Blended(font, c, GLYPH_COLOR);
+    if (surfaces[i] == NULL) {
+      continue;
+    }
+    int w = surfaces[i]->w, h = surfaces[i]->h;
+    assert(w <= ATLAS_WIDTH);
+    if (x + w > ATLAS_WIDTH) {
+      x = 0;
+      y += row_height + GLYPH_PADDING;
+      row_height = 0;
+    }
+    glyph->src = (SDL_Rect){x, y, w, h};
+    x += w + GLYPH_PADDING;
+    if (h > row_height) {
+      row_height = h;
+    }
+  }
+  atlas->width = ATLAS_WIDTH;
+  atlas->height = y + row_height > 0 ? y + row_height : 1;
+
+  SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(
+      0, atlas->width, atlas->height, 32, SDL_PIXELFORMAT_RGBA32);
+  assert(sheet != NULL);
+  for (size_t i = 0; i < count; i++) {
+    if (surfaces[i] != NULL) {
+      // Copy the glyph's alpha as is instead of blending it onto the sheet
+      SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+      SDL_BlitSurface(surfaces[i], NULL, sheet, &atlas->glyphs[i].src);
+      SDL_FreeSurface(surfaces[i]);
+    }
+  }
+  free(surfaces);
+  atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+  assert(atlas->texture != NULL);
+  SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+  SDL_FreeSurface(sheet);
+
+  atlas->batch = quad_batch_init();
+  return atlas;
+}
+
+void glyph_atlas_free(glyph_atlas_t *atlas) {
+  SDL_DestroyTexture(atlas->texture);
+  free(atlas->glyphs);
+  quad_batch_free(atlas->batch);
+  free(atlas);
+}
+
+/**
+ * Gets the glyph that draws a character.
+ */
+glyph_t *glyph_atlas_get(glyph_atlas_t *atlas, char c) {
+  if (c < FIRST_GLYPH || c > LAST_GLYPH) {
+    c = MISSING_GLYPH;
+  }
+  return &atlas->glyphs[c - FIRST_GLYPH];
+}
+
+int glyph_atlas_measure(glyph_atlas_t *atlas, const char *str) {
+  int width = 0;
+  for (const char *c = str; *c != '\0'; c++) {
+    width += glyph_atlas_get(atlas, *c)->advance;
+  }
+  return width;
+}
+
+void glyph_atlas_queue(glyph_atlas_t *atlas, const char *str, vector_t pos,
+                       SDL_Color color) {
+  // SDL_ttf ignores alpha, so colors written without one are opaque there
+  if (color.a == 0) {
+    color.a = SDL_ALPHA_OPAQUE;
+  }
+  SDL_Rect dst = {.x = pos.x, .y = pos.y};
+  for (const char *c = str; *c != '\0'; c++) {
+    glyph_t *glyph = glyph_atlas_get(atlas, *c);
+    if (glyph->src.w > 0) {
+      dst.w = glyph->src.w;
+      dst.h = glyph->src.h;
+      quad_batch_add(atlas->batch, dst, glyph->src, atlas->width,
+                     atlas->height, color);
+    }
+    dst.x += glyph->advance;
+  }
+}
+
+size_t glyph_atlas_queued(glyph_atlas_t *atlas) {
+  return quad_batch_size(atlas->batch);
+}
+
+void glyph_atlas_flush(glyph_atlas_t *atlas, SDL_Renderer *renderer) {
+  quad_batch_flush(atlas->batch, renderer, atlas->texture);
+}
@@ -8,6 +8,7 @@
 #include "list.h"
 #include "multiball_lvl1.h"
 #include "polygon.h"
+#include "prototype.h"
 #include "random.h"
 #include "sdl_wrapper.h"
 #include "shapes.h"
@@ -29,9 +30,9 @@ static const vector_t BLACK_HOLE_2_POS = {WINDOW_WIDTH * 2 / 3,
 static const int END_SCORE = 7;
 
 void grav_lvl1_add_black_hole(state_t *state, vector_t pos) {
-  list_t *shape =
-      make_ellipse(BLACK_HOLE_RADIUS, BLACK_HOLE_RADIUS, BLACK_HOLE_NVERTICES);
-  body_t *grav = body_init_shape(shape, BLACK_HOLE_MASS, BLACK_HOLE_COLOR);
+  prototype_t *shape = prototype_ellipse(BLACK_HOLE_RADIUS, BLACK_HOLE_RADIUS,
+                                         BLACK_HOLE_NVERTICES);
+  body_t *grav = body_init_prototype(shape, BLACK_HOLE_MASS, BLACK_HOLE_COLOR);
   body_t *pellet = state_get_pellet(state, 0);
   body_set_centroid(grav, pos);
   scene_add_body(state_get_scene(state), grav);
@@ -91,6 +92,8 @@ void grav_lvl1_init(game_t *game) {
   game_set_state(game, state);
 
   scene_set_texture(state_get_scene(state), CALTECH_HALL_NIGHT_FILE);
+  // pellets swing close past the black holes, where gravity changes fastest
+  scene_set_integrator(state_get_scene(state), INTEGRATOR_RK4);
 
   level_add_player(game);
   level_add_ai(game);
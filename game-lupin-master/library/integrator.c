@@ -0,0 +1,206 @@
+#include "integrator.h"
+#include "body.h"
+#include "forces.h"
+#include "list.h"
+#include "vector.h"
+#include <assert.h>
+#include <stdlib.h>
+
+static const size_t INIT_INTEGRATION_CAPACITY = 16;
+// RK4 stages after the first: their step scale and their weight in the sum
+static const size_t RK4_STAGES = 3;
+static const double RK4_STAGE_SCALE[] = {0.5, 0.5, 1};
+static const double RK4_STAGE_WEIGHT[] = {2, 2, 1};
+
+typedef struct body_state {
+  // the field force recorded at the start of the tick
+  vector_t field_force;
+  // the acceleration from forces held constant over the tick
+  vector_t constant_acc;
+  // the position and (kicked) velocity at the start of the tick
+  vector_t pos;
+  vector_t vel;
+  // the derivative (velocity, acceleration) of the last stage
+  vector_t stage_vel;
+  vector_t stage_acc;
+  // the weighted sums of the stage derivatives
+  vector_t sum_vel;
+  vector_t sum_acc;
+} body_state_t;
+
+typedef struct integration {
+  body_state_t *states;
+  size_t capacity;
+} integration_t;
+
+void integration_reserve(integration_t *integration, size_t size) {
+  if (size <= integration->capacity) {
+    return;
+  }
+  while (integration->capacity < size) {
+    integration->capacity *= 2;
+  }
+  integration->states = realloc(integration->states,
+                                sizeof(body_state_t) * integration->capacity);
+  assert(integration->states != NULL);
+}
+
+integration_t *integration_init(void) {
+  integration_t *integration = malloc(sizeof(integration_t));
+  assert(integration != NULL);
+  integration->capacity = INIT_INTEGRATION_CAPACITY;
+  integration->states =
+      malloc(sizeof(body_state_t) * integration->capacity);
+  assert(integration->states != NULL);
+  return integration;
+}
+
+void integration_free(integration_t *integration) {
+  free(integration->states);
+  free(integration);
+}
+
+void integration_record_field_forces(integration_t *integration,
+                                     list_t *bodies) {
+  integration_reserve(integration, list_size(bodies));
+  for (size_t i = 0; i < list_size(bodies); i++) {
+    integration->states[i].field_force = body_get_force(list_get(bodies, i));
+  }
+}
+
+/**
+ * Moves every awake body to a stage state, re-runs the field forces there
+ * and sets each body's stage derivative.
+ * The bodies are left at the stage state; the final step moves them on.
+ */
+void integration_evaluate(integration_t *integration, list_t *bodies,
+                          list_t *forces, double scale) {
+  size_t size = list_size(bodies);
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(bodies, i);
+    body_state_t *state = &integration->states[i];
+    if (!body_is_sleeping(body)) {
+      body_set_centroid(body, vec_add(state->pos,
+                                      vec_multiply(scale, state->stage_vel)));
+      state->stage_vel =
+          vec_add(state->vel, vec_multiply(scale, state->stage_acc));
+      body_set_velocity(body, state->stage_vel);
+    }
+    body_clear_forces(body);
+  }
+  for (size_t i = 0; i < list_size(forces); i++) {
+    force_t *force = list_get(forces, i);
+    if (force_is_field(force)) {
+      apply_force_creator(force);
+    }
+  }
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(bodies, i);
+    body_state_t *state = &integration->states[i];
+    state->stage_acc =
+        vec_add(state->constant_acc, vec_multiply(body_get_inverse_mass(body),
+                                                  body_get_force(body)));
+  }
+}
+
+/** Adds the last stage's derivative to the weighted sums */
+void integration_accumulate(integration_t *integration, size_t size,
+                            double weight) {
+  for (size_t i = 0; i < size; i++) {
+    body_state_t *state = &integration->states[i];
+    state->sum_vel =
+        vec_add(state->sum_vel, vec_multiply(weight, state->stage_vel));
+    state->sum_acc =
+        vec_add(state->sum_acc, vec_multiply(weight, state->stage_acc));
+  }
+}
+
+void integration_step(integration_t *integration, integrator_t integrator,
+                      list_t *bodies, list_t *forces, double dt) {
+  size_t size = list_size(bodies);
+  if (integrator == INTEGRATOR_AVERAGE) {
+    for (size_t i = 0; i < size; i++) {
+      body_tick(list_get(bodies, i), dt);
+    }
+    return;
+  }
+  integration_reserve(integration, size);
+
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(bodies, i);
+    body_state_t *state = &integration->states[i];
+    double inv_mass = body_get_inverse_mass(body);
+    state->constant_acc = vec_multiply(
+        inv_mass, vec_subtract(body_get_force(body), state->field_force));
+    state->pos = body_get_centroid(body);
+    state->vel = vec_add(body_get_velocity(body),
+                         vec_multiply(inv_mass, body_get_impulse(body)));
+    state->stage_acc = vec_multiply(inv_mass, body_get_force(body));
+  }
+
+  if (integrator == INTEGRATOR_SEMI_IMPLICIT_EULER) {
+    for (size_t i = 0; i < size; i++) {
+      body_state_t *state = &integration->states[i];
+      state->sum_vel = body_drag_velocity(list_get(bodies, i), state->vel,
+                                          state->stage_acc, dt, NULL);
+      state->pos = vec_add(state->pos, vec_multiply(dt, state->sum_vel));
+    }
+  } else {
+    // apply half of the drag decay before the stages and half after,
+    // leaving the stages themselves drag-free
+    for (size_t i = 0; i < size; i++) {
+      body_state_t *state = &integration->states[i];
+      state->vel = body_drag_velocity(list_get(bodies, i), state->vel,
+                                      VEC_ZERO, dt / 2, NULL);
+      state->stage_vel = state->vel;
+      state->sum_vel = state->vel;
+      state->sum_acc = state->stage_acc;
+    }
+    if (integrator == INTEGRATOR_VELOCITY_VERLET) {
+      // x1 = x0 + v0 dt + a0 dt^2 / 2 and v1 = v0 + (a0 + a1) dt / 2
+      for (size_t i = 0; i < size; i++) {
+        body_state_t *state = &integration->states[i];
+        state->stage_vel =
+            vec_add(state->vel, vec_multiply(dt / 2, state->stage_acc));
+      }
+      integration_evaluate(integration, bodies, forces, dt);
+      for (size_t i = 0; i < size; i++) {
+        body_state_t *state = &integration->states[i];
+        // the stage moved the body by stage_vel * dt, i.e. v0 + a0 dt / 2
+        state->pos = body_get_centroid(list_get(bodies, i));
+        state->sum_vel = vec_add(
+            state->vel, vec_multiply(dt / 2, vec_add(state->sum_acc,
+                                                     state->stage_acc)));
+      }
+    } else {
+      for (size_t s = 0; s < RK4_STAGES; s++) {
+        integration_evaluate(integration, bodies, forces,
+                             dt * RK4_STAGE_SCALE[s]);
+        integration_accumulate(integration, size, RK4_STAGE_WEIGHT[s]);
+      }
+      for (size_t i = 0; i < size; i++) {
+        body_state_t *state = &integration->states[i];
+        state->pos = vec_add(state->pos, vec_multiply(dt / 6, state->sum_vel));
+        state->sum_vel =
+            vec_add(state->vel, vec_multiply(dt / 6, state->sum_acc));
+      }
+    }
+    for (size_t i = 0; i < size; i++) {
+      body_state_t *state = &integration->states[i];
+      state->sum_vel = body_drag_velocity(list_get(bodies, i), state->sum_vel,
+                                          VEC_ZERO, dt / 2, NULL);
+    }
+  }
+
+  // sum_vel now holds each body's final velocity and pos its final position
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(bodies, i);
+    body_state_t *state = &integration->states[i];
+    if (!body_is_sleeping(body)) {
+      body_set_centroid(body, state->pos);
+      body_set_velocity(body, state->sum_vel);
+      body_rotate(body, dt * body_get_rot_velocity(body));
+    }
+    body_clear_forces(body);
+  }
+}
@@ -0,0 +1,164 @@
+#include "island.h"
+#include "body.h"
+#include "forces.h"
+#include "list.h"
+#include "solver.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const size_t INIT_ISLANDS_CAPACITY = 16;
+// Speeds under these (pixels/s and radians/s) count as resting
+static const double SLEEP_LINEAR_VELOCITY = 2;
+static const double SLEEP_ANGULAR_VELOCITY = 0.05;
+// How long an island must rest before it falls asleep, in seconds
+static const double TIME_TO_SLEEP = 0.5;
+
+typedef struct islands {
+  // union-find forest over the bodies of the last update
+  size_t *parent;
+  // per root: the smallest rest time and whether any body is awake
+  double *rest_time;
+  bool *awake;
+  size_t capacity;
+  size_t count;
+} islands_t;
+
+islands_t *islands_init(void) {
+  islands_t *islands = malloc(sizeof(islands_t));
+  assert(islands != NULL);
+  islands->capacity = INIT_ISLANDS_CAPACITY;
+  islands->parent = malloc(sizeof(size_t) * islands->capacity);
+  islands->rest_time = malloc(sizeof(double) * islands->capacity);
+  islands->awake = malloc(sizeof(bool) * islands->capacity);
+  assert(islands->parent != NULL && islands->rest_time != NULL &&
+         islands->awake != NULL);
+  islands->count = 0;
+  return islands;
+}
+
+void islands_free(islands_t *islands) {
+  free(islands->parent);
+  free(islands->rest_time);
+  free(islands->awake);
+  free(islands);
+}
+
+void islands_reserve(islands_t *islands, size_t size) {
+  if (size <= islands->capacity) {
+    return;
+  }
+  while (islands->capacity < size) {
+    islands->capacity *= 2;
+  }
+  islands->parent =
+      realloc(islands->parent, sizeof(size_t) * islands->capacity);
+  islands->rest_time =
+      realloc(islands->rest_time, sizeof(double) * islands->capacity);
+  islands->awake = realloc(islands->awake, sizeof(bool) * islands->capacity);
+  assert(islands->parent != NULL && islands->rest_time != NULL &&
+         islands->awake != NULL);
+}
+
+/** Finds the root of a body's island, halving the path on the way */
+size_t islands_find(islands_t *islands, size_t index) {
+  while (islands->parent[index] != index) {
+    islands->parent[index] = islands->parent[islands->parent[index]];
+    index = islands->parent[index];
+  }
+  return index;
+}
+
+void islands_union(islands_t *islands, size_t a, size_t b) {
+  size_t root_a = islands_find(islands, a);
+  size_t root_b = islands_find(islands, b);
+  if (root_a != root_b) {
+    islands->parent[root_b] = root_a;
+  }
+}
+
+/** Adds a tick to the body's rest time, or restarts it if the body moved */
+void islands_update_rest_time(body_t *body, double dt) {
+  if (body_is_sleeping(body)) {
+    return;
+  }
+  vector_t vel = body_get_velocity(body);
+  if (vec_dot(vel, vel) > SLEEP_LINEAR_VELOCITY * SLEEP_LINEAR_VELOCITY ||
+      fabs(body_get_rot_velocity(body)) > SLEEP_ANGULAR_VELOCITY) {
+    body_set_rest_time(body, 0);
+  } else {
+    body_set_rest_time(body, body_get_rest_time(body) + dt);
+  }
+}
+
+/** Links two bodies, unless one of them can't pass motion on */
+void islands_link(islands_t *islands, body_t *body1, body_t *body2) {
+  if (body_get_inverse_mass(body1) > 0 && body_get_inverse_mass(body2) > 0) {
+    islands_union(islands, body_get_island(body1), body_get_island(body2));
+  }
+}
+
+void islands_update(islands_t *islands, list_t *bodies, list_t *forces,
+                    solver_t *solver, double dt) {
+  size_t size = list_size(bodies);
+  islands_reserve(islands, size);
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(bodies, i);
+    islands_update_rest_time(body, dt);
+    // index bodies so contacts can find their union-find nodes
+    body_set_island(body, i);
+    islands->parent[i] = i;
+  }
+
+  for (size_t i = 0; i < list_size(forces); i++) {
+    force_t *force = list_get(forces, i);
+    if (!force_links_bodies(force)) {
+      continue;
+    }
+    list_t *force_bodies = force_get_bodies(force);
+    for (size_t j = 1; j < list_size(force_bodies); j++) {
+      islands_link(islands, list_get(force_bodies, 0),
+                   list_get(force_bodies, j));
+    }
+  }
+  for (size_t i = 0; i < solver_contacts(solver); i++) {
+    contact_t *contact = solver_get_contact(solver, i);
+    islands_link(islands, contact_get_body1(contact),
+                 contact_get_body2(contact));
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    islands->rest_time[i] = INFINITY;
+    islands->awake[i] = false;
+  }
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(bodies, i);
+    size_t root = islands_find(islands, i);
+    islands->rest_time[root] =
+        fmin(islands->rest_time[root], body_get_rest_time(body));
+    if (!body_is_sleeping(body)) {
+      islands->awake[root] = true;
+    }
+  }
+
+  islands->count = 0;
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(bodies, i);
+    size_t root = islands_find(islands, i);
+    body_set_island(body, root);
+    if (root == i) {
+      islands->count++;
+    }
+    if (islands->rest_time[root] >= TIME_TO_SLEEP) {
+      if (!body_is_sleeping(body)) {
+        body_sleep(body);
+      }
+    } else if (islands->awake[root] && body_is_sleeping(body)) {
+      body_wake(body);
+    }
+  }
+}
+
+size_t islands_count(islands_t *islands) { return islands->count; }
@@ -7,6 +7,7 @@
 #include "grav_lvl1.h"
 #include "list.h"
 #include "polygon.h"
+#include "prototype.h"
 #include "random.h"
 #include "sdl_wrapper.h"
 #include "shapes.h"
@@ -32,16 +33,18 @@ static const double PELLET_MAX_INIT_VERICAL_VEL = 500;
 
 static const vector_t PLAYER_INIT_POS = {50, WINDOW_HEIGHT / 2};
 static const vector_t AI_INIT_POS = {WINDOW_WIDTH - 50, WINDOW_HEIGHT / 2};
+// The AI only keeps track of this many pellets at once
+static const size_t AI_MAX_TRACKED_PELLETS = 16;
 
 void level_add_walls(state_t *state) {
-  body_t *left = body_init_shape(make_rect(WALL_THICCNESS, PLAYSCREEN.y),
-                                 INFINITY, WALL_COLOR);
-  body_t *right = body_init_shape(make_rect(WALL_THICCNESS, PLAYSCREEN.y),
-                                  INFINITY, WALL_COLOR);
-  body_t *top = body_init_shape(make_rect(PLAYSCREEN.x, WALL_THICCNESS),
-                                INFINITY, WALL_COLOR);
-  body_t *bottom = body_init_shape(make_rect(PLAYSCREEN.x, WALL_THICCNESS),
-                                   INFINITY, WALL_COLOR);
+  body_t *left = body_init_prototype(
+      prototype_rect(WALL_THICCNESS, PLAYSCREEN.y), INFINITY, WALL_COLOR);
+  body_t *right = body_init_prototype(
+      prototype_rect(WALL_THICCNESS, PLAYSCREEN.y), INFINITY, WALL_COLOR);
+  body_t *top = body_init_prototype(
+      prototype_rect(PLAYSCREEN.x, WALL_THICCNESS), INFINITY, WALL_COLOR);
+  body_t *bottom = body_init_prototype(
+      prototype_rect(PLAYSCREEN.x, WALL_THICCNESS), INFINITY, WALL_COLOR);
 
   body_set_centroid(left, (vector_t){-(WALL_THICCNESS / 2), PLAYSCREEN.y / 2});
   body_set_centroid(
@@ -49,6 +52,13 @@ void level_add_walls(state_t *state) {
   body_set_centroid(
       top, (vector_t){PLAYSCREEN.x / 2, PLAYSCREEN.y + (WALL_THICCNESS / 2)});
   body_set_centroid(bottom, (vector_t){PLAYSCREEN.x / 2, -WALL_THICCNESS / 2});
+  // the side walls are goals, so pellets pass into them and score
+  body_set_sensor(left, true);
+  body_set_sensor(right, true);
+  body_set_static(left, true);
+  body_set_static(right, true);
+  body_set_static(top, true);
+  body_set_static(bottom, true);
 
   state_add_wall(state, left);
   state_add_wall(state, right);
@@ -77,46 +87,45 @@ void level_reset_ai(state_t *state) {
 
 void level_update_points_text(state_t *state) {
   scene_t *scene = state_get_scene(state);
-  char *p1_points = malloc(sizeof(SCORE_STRING_MAX_LENGTH));
-  char *p2_points = malloc(sizeof(SCORE_STRING_MAX_LENGTH));
-  sprintf(p1_points, "%d", state_get_p1_points(state));
-  sprintf(p2_points, "%d", state_get_p2_points(state));
-  scene_remove_text(scene, 0);
-  scene_remove_text(scene, 0);
-  text_t *player_score = text_init(p1_points, SCORE_POS_P1, 20);
-  text_t *ai_score = text_init(p2_points, SCORE_POS_P2, 20);
-  scene_add_text(scene, player_score);
-  scene_add_text(scene, ai_score);
+  char p1_points[SCORE_STRING_MAX_LENGTH + 1];
+  char p2_points[SCORE_STRING_MAX_LENGTH + 1];
+  snprintf(p1_points, sizeof(p1_points), "%d", state_get_p1_points(state));
+  snprintf(p2_points, sizeof(p2_points), "%d", state_get_p2_points(state));
+  scene_update_text(scene, 0, p1_points);
+  scene_update_text(scene, 1, p2_points);
+}
+
+void level_goal_scored(state_t *state) {
+  SDL_Init(SDL_INIT_AUDIO);
+  Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
+  Mix_Chunk *chunk = Mix_LoadWAV("/extras/se_pacman_win3_1up.wav");
+  Mix_PlayChannel(-1, chunk, 0);
+  // scene_add_noise(state_get_scene(state), chunk);
+  level_update_points_text(state);
+  level_reset_pellets(state);
+  level_reset_ai(state);
 }
 
 void level_score_check(state_t *state) {
+  scene_t *scene = state_get_scene(state);
   body_t *l_wall = state_get_wall(state, 0);
   body_t *r_wall = state_get_wall(state, 1);
-  body_t *pellet = state_get_pellet(state, 0);
-  bool l_coll =
-      (find_collision(body_get_shape(l_wall), body_get_shape(pellet)).collided);
-  bool r_coll =
-      (find_collision(body_get_shape(r_wall), body_get_shape(pellet)).collided);
-  if (r_coll) {
-    SDL_Init(SDL_INIT_AUDIO);
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
-    Mix_Chunk *chunk = Mix_LoadWAV("/extras/se_pacman_win3_1up.wav");
-    Mix_PlayChannel(-1, chunk, 0);
-    // scene_add_noise(state_get_scene(state), chunk);
-    state_add_p1_point(state);
-    level_update_points_text(state);
-    level_reset_pellets(state);
-    level_reset_ai(state);
-  } else if (l_coll) {
-    SDL_Init(SDL_INIT_AUDIO);
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
-    Mix_Chunk *chunk = Mix_LoadWAV("/extras/se_pacman_win3_1up.wav");
-    Mix_PlayChannel(-1, chunk, 0);
-    // scene_add_noise(state_get_scene(state), chunk);
-    state_add_p2_point(state);
-    level_update_points_text(state);
-    level_reset_pellets(state);
-    level_reset_ai(state);
+  list_t *pellets = state_get_pellets(state);
+  for (size_t i = 0; i < scene_trigger_events(scene); i++) {
+    trigger_event_t event = scene_get_trigger_event(scene, i);
+    if (!event.begin || !list_contains(pellets, event.other)) {
+      continue;
+    }
+    // every pellet is reset, so later events this tick are stale
+    if (event.sensor == r_wall) {
+      state_add_p1_point(state);
+      level_goal_scored(state);
+      return;
+    } else if (event.sensor == l_wall) {
+      state_add_p2_point(state);
+      level_goal_scored(state);
+      return;
+    }
   }
 }
 
@@ -139,17 +148,52 @@ void level_add_ai(game_t *game) {
 }
 
 void level_add_pellet(state_t *state) {
-  body_t *pellet = body_init_shape(
-      make_ellipse(PELLET_RADIUS, PELLET_RADIUS, PELLET_VERTICES), PELLET_MASS,
-      PELLET_COLOR);
+  body_t *pellet = body_init_prototype(
+      prototype_ellipse(PELLET_RADIUS, PELLET_RADIUS, PELLET_VERTICES),
+      PELLET_MASS, PELLET_COLOR);
   body_set_texture_scaled(pellet, PELLET_TEXTURE_FILE, PELLET_TEXTURE_SCALING);
   state_add_pellet(state, pellet);
   level_reset_pellets(state);
 }
 
+/**
+ * Picks the pellet the AI should follow: the one that will reach its paddle
+ * first, or the closest one if none is heading its way.
+ */
+body_t *level_ai_target(state_t *state, body_t *ai) {
+  body_t *pellets[AI_MAX_TRACKED_PELLETS];
+  aabb_t court = {VEC_ZERO, PLAYSCREEN};
+  size_t count =
+      scene_query_aabb_buffer(state_get_scene(state), court, PELLET_CATEGORY,
+                              pellets, AI_MAX_TRACKED_PELLETS);
+  double ai_x = body_get_centroid(ai).x;
+  body_t *target = NULL;
+  double best_time = INFINITY;
+  double best_dist = INFINITY;
+  for (size_t i = 0; i < count; i++) {
+    vector_t pos = body_get_centroid(pellets[i]);
+    double vel_x = body_get_velocity(pellets[i]).x;
+    double dist = fabs(ai_x - pos.x);
+    if (vel_x > 0 && pos.x < ai_x) {
+      double time = (ai_x - pos.x) / vel_x;
+      if (time < best_time) {
+        best_time = time;
+        target = pellets[i];
+      }
+    } else if (best_time == INFINITY && dist < best_dist) {
+      best_dist = dist;
+      target = pellets[i];
+    }
+  }
+  return target;
+}
+
 void level_ai_move(state_t *state) {
   body_t *ai = state_get_paddle(state, 1);
-  body_t *pellet = state_get_pellet(state, 0);
+  body_t *pellet = level_ai_target(state, ai);
+  if (pellet == NULL) {
+    pellet = state_get_pellet(state, 0);
+  }
   vector_t up_v = {.x = 0, .y = 1.0 * AI_TOP_SPEED};
   vector_t down_v = {.x = 0, .y = -1.0 * AI_TOP_SPEED};
   double dif = body_get_centroid(pellet).y - body_get_centroid(ai).y;
@@ -209,8 +253,10 @@ void level_check_pellet_velocity(state_t *state) {
 
 void level_add_score_text(state_t *state) {
   text_t *player_score = text_init("0", SCORE_POS_P1, 20);
+  text_set_dynamic(player_score, true);
   scene_add_text(state_get_scene(state), player_score);
   text_t *ai_score = text_init("0", SCORE_POS_P2, 20);
+  text_set_dynamic(ai_score, true);
   scene_add_text(state_get_scene(state), ai_score);
 }
 
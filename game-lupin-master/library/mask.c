@@ -0,0 +1,136 @@
+#include "mask.h"
+#include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static const size_t WORD_BITS = 64;
+static const size_t RGBA_ALPHA_OFFSET = 3;
+static const size_t RGBA_BYTES = 4;
+
+typedef struct mask {
+  size_t width;
+  size_t height;
+  size_t words_per_row;
+  uint64_t *words;
+} mask_t;
+
+mask_t *mask_init(size_t width, size_t height) {
+  mask_t *mask = malloc(sizeof(mask_t));
+  assert(mask != NULL);
+  mask->width = width;
+  mask->height = height;
+  mask->words_per_row = (width + WORD_BITS - 1) / WORD_BITS;
+  mask->words = calloc(mask->words_per_row * height + 1, sizeof(uint64_t));
+  assert(mask->words != NULL);
+  return mask;
+}
+
+mask_t *mask_from_surface(SDL_Surface *surface, uint8_t alpha_threshold) {
+  mask_t *mask = mask_init(surface->w, surface->h);
+  SDL_LockSurface(surface);
+  const uint8_t *pixels = surface->pixels;
+  for (size_t y = 0; y < mask->height; y++) {
+    const uint8_t *row = pixels + y * surface->pitch;
+    uint64_t *words = &mask->words[y * mask->words_per_row];
+    for (size_t x = 0; x < mask->width; x++) {
+      if (row[x * RGBA_BYTES + RGBA_ALPHA_OFFSET] >= alpha_threshold) {
+        words[x / WORD_BITS] |= (uint64_t)1 << (x % WORD_BITS);
+      }
+    }
+  }
+  SDL_UnlockSurface(surface);
+  return mask;
+}
+
+void mask_free(mask_t *mask) {
+  free(mask->words);
+  free(mask);
+}
+
+size_t mask_width(mask_t *mask) { return mask->width; }
+
+size_t mask_height(mask_t *mask) { return mask->height; }
+
+bool mask_get(mask_t *mask, int x, int y) {
+  if (x < 0 || y < 0 || (size_t)x >= mask->width ||
+      (size_t)y >= mask->height) {
+    return false;
+  }
+  uint64_t word = mask->words[y * mask->words_per_row + x / WORD_BITS];
+  return (word >> (x % WORD_BITS)) & 1;
+}
+
+void mask_set(mask_t *mask, int x, int y, bool value) {
+  assert(x >= 0 && y >= 0 && (size_t)x < mask->width &&
+         (size_t)y < mask->height);
+  uint64_t *word = &mask->words[y * mask->words_per_row + x / WORD_BITS];
+  uint64_t bit = (uint64_t)1 << (x % WORD_BITS);
+  *word = value ? *word | bit : *word & ~bit;
+}
+
+/** Gets a word of a row, or 0 past either end of the row */
+uint64_t mask_word(mask_t *mask, size_t y, long index) {
+  if (index < 0 || (size_t)index >= mask->words_per_row) {
+    return 0;
+  }
+  return mask->words[y * mask->words_per_row + index];
+}
+
+/** Gets the 64 pixels of a row starting at column x, which may be negative */
+uint64_t mask_row_bits(mask_t *mask, size_t y, long x) {
+  long index = x >= 0 ? x / (long)WORD_BITS
+                      : -((-x + (long)WORD_BITS - 1) / (long)WORD_BITS);
+  size_t shift = x - index * (long)WORD_BITS;
+  uint64_t bits = mask_word(mask, y, index) >> shift;
+  if (shift > 0) {
+    bits |= mask_word(mask, y, index + 1) << (WORD_BITS - shift);
+  }
+  return bits;
+}
+
+bool mask_row_any(mask_t *mask, int y, int x0, int x1) {
+  if (y < 0 || (size_t)y >= mask->height) {
+    return false;
+  }
+  x0 = x0 < 0 ? 0 : x0;
+  x1 = x1 > (int)mask->width ? (int)mask->width : x1;
+  for (int x = x0; x < x1; x += WORD_BITS) {
+    uint64_t bits = mask_row_bits(mask, y, x);
+    int count = x1 - x;
+    if ((size_t)count < WORD_BITS) {
+      bits &= ((uint64_t)1 << count) - 1;
+    }
+    if (bits != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool mask_overlap(mask_t *mask1, mask_t *mask2, int dx, int dy) {
+  long y0 = dy > 0 ? dy : 0;
+  long y1 = (long)mask2->height + dy;
+  y1 = y1 < (long)mask1->height ? y1 : (long)mask1->height;
+  long x0 = dx > 0 ? dx : 0;
+  long x1 = (long)mask2->width + dx;
+  x1 = x1 < (long)mask1->width ? x1 : (long)mask1->width;
+  if (x0 >= x1) {
+    return false;
+  }
+  size_t first_word = x0 / WORD_BITS;
+  size_t last_word = (x1 - 1) / WORD_BITS;
+  for (long y = y0; y < y1; y++) {
+    for (size_t w = first_word; w <= last_word; w++) {
+      // mask2's pixels past its edges are clear, so no need to trim them
+      uint64_t bits1 = mask1->words[y * mask1->words_per_row + w];
+      uint64_t bits2 = mask_row_bits(mask2, y - dy, (long)(w * WORD_BITS) - dx);
+      if ((bits1 & bits2) != 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
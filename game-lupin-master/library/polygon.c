@@ -1,8 +1,12 @@
 #include "polygon.h"
 #include "list.h"
 #include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
 
 static const double CENTROID_CONSTANT = 1 / 6.;
+static const size_t MIN_POLYGON_VERTICES = 3;
 
 double polygon_area(list_t *polygon) {
   vector_t *prev;
@@ -22,21 +26,189 @@ double polygon_area(list_t *polygon) {
 }
 
 vector_t polygon_centroid(list_t *polygon) {
+  return polygon_properties(polygon).centroid;
+}
+
+polygon_props_t polygon_properties(list_t *polygon) {
+  size_t size = list_size(polygon);
+  vector_t prev = *((vector_t *)list_get(polygon, size - 1));
+  aabb_t bounds = {.min = prev, .max = prev};
+  double sum = 0.;
   double cx = 0.;
   double cy = 0.;
+  for (size_t i = 0; i < size; i++) {
+    vector_t curr = *((vector_t *)list_get(polygon, i));
+    double cross = vec_cross(prev, curr);
+    sum += cross;
+    cx += (prev.x + curr.x) * cross;
+    cy += (prev.y + curr.y) * cross;
+    bounds.min.x = fmin(bounds.min.x, curr.x);
+    bounds.min.y = fmin(bounds.min.y, curr.y);
+    bounds.max.x = fmax(bounds.max.x, curr.x);
+    bounds.max.y = fmax(bounds.max.y, curr.y);
+    prev = curr;
+  }
+  // the signed area cancels out of the centroid, so orientation doesn't matter
+  polygon_props_t props;
+  props.area = 0.5 * fabs(sum);
+  props.centroid =
+      vec_multiply(2 * CENTROID_CONSTANT / sum, (vector_t){.x = cx, .y = cy});
+  props.bounds = bounds;
+  return props;
+}
+
+double polygon_radius(list_t *polygon, vector_t point) {
+  double max_sq = 0;
+  for (size_t i = 0; i < list_size(polygon); i++) {
+    vector_t diff = vec_subtract(*((vector_t *)list_get(polygon, i)), point);
+    double dist_sq = vec_dot(diff, diff);
+    if (dist_sq > max_sq) {
+      max_sq = dist_sq;
+    }
+  }
+  return sqrt(max_sq);
+}
+
+int compare_points(const void *a, const void *b) {
+  const vector_t *p = a, *q = b;
+  if (p->x != q->x) {
+    return p->x < q->x ? -1 : 1;
+  }
+  if (p->y != q->y) {
+    return p->y < q->y ? -1 : 1;
+  }
+  return 0;
+}
+
+list_t *polygon_convex_hull(list_t *points) {
+  size_t n = list_size(points);
+  assert(n > 0);
+  vector_t *sorted = malloc(sizeof(vector_t) * n);
+  vector_t *hull = malloc(sizeof(vector_t) * (2 * n + 1));
+  assert(sorted != NULL);
+  assert(hull != NULL);
+  for (size_t i = 0; i < n; i++) {
+    sorted[i] = *((vector_t *)list_get(points, i));
+  }
+  qsort(sorted, n, sizeof(vector_t), compare_points);
+
+  // lower hull left to right, then upper hull right to left.
+  // Popping on a non-left turn (cross <= 0) also drops collinear points,
+  // and duplicates are collinear with their twin.
+  size_t k = 0;
+  for (size_t i = 0; i < n; i++) {
+    while (k >= 2 && vec_cross(vec_subtract(hull[k - 1], hull[k - 2]),
+                               vec_subtract(sorted[i], hull[k - 2])) <= 0) {
+      k--;
+    }
+    hull[k++] = sorted[i];
+  }
+  for (size_t i = n - 1, lower = k + 1; i-- > 0;) {
+    while (k >= lower && vec_cross(vec_subtract(hull[k - 1], hull[k - 2]),
+                                   vec_subtract(sorted[i], hull[k - 2])) <= 0) {
+      k--;
+    }
+    hull[k++] = sorted[i];
+  }
+  // the last point repeats the first one
+  size_t size = k > 1 ? k - 1 : k;
+
+  list_t *result = list_init(size, free);
+  for (size_t i = 0; i < size; i++) {
+    vector_t *vertex = malloc(sizeof(vector_t));
+    assert(vertex != NULL);
+    *vertex = hull[i];
+    list_add(result, vertex);
+  }
+  free(sorted);
+  free(hull);
+  return result;
+}
+
+/**
+ * Computes how far the original vertices strictly between from and to
+ * (counterclockwise, wrapping around) are from the segment joining those
+ * two, i.e. how far the outline moves if they are all replaced by it.
+ */
+double polygon_chord_deviation(vector_t *original, size_t size, size_t from,
+                               size_t to) {
+  vector_t start = original[from];
+  vector_t chord = vec_subtract(original[to], start);
+  double length = vec_magnitude(chord);
+  double deviation = 0;
+  for (size_t i = (from + 1) % size; i != to; i = (i + 1) % size) {
+    vector_t offset = vec_subtract(original[i], start);
+    double distance = length == 0 ? vec_magnitude(offset)
+                                  : fabs(vec_cross(chord, offset)) / length;
+    deviation = fmax(deviation, distance);
+  }
+  return deviation;
+}
+
+void polygon_simplify(list_t *polygon, double tolerance) {
   size_t size = list_size(polygon);
-  for (size_t i = 0; i < size - 1; i++) {
-    vector_t v1 = *((vector_t *)list_get(polygon, i));
-    vector_t v2 = *((vector_t *)list_get(polygon, i + 1));
-    cx += (v1.x + v2.x) * (v1.x * v2.y - v2.x * v1.y);
-    cy += (v1.y + v2.y) * (v1.x * v2.y - v2.x * v1.y);
-  }
-  vector_t v0 = *((vector_t *)list_get(polygon, 0));
-  vector_t vl = *((vector_t *)list_get(polygon, size - 1));
-  cx += (vl.x + v0.x) * (vl.x * v0.y - v0.x * vl.y);
-  cy += (vl.y + v0.y) * (vl.x * v0.y - v0.x * vl.y);
-  return vec_multiply(CENTROID_CONSTANT / polygon_area(polygon),
-                      (vector_t){.x = cx, .y = cy});
+  // each removal is measured against the original outline, so errors from
+  // earlier removals can't add up past the tolerance
+  vector_t *original = malloc(sizeof(vector_t) * size);
+  assert(original != NULL);
+  // the original index of each vertex still in the polygon
+  size_t *kept = malloc(sizeof(size_t) * size);
+  assert(kept != NULL);
+  for (size_t i = 0; i < size; i++) {
+    original[i] = *((vector_t *)list_get(polygon, i));
+    kept[i] = i;
+  }
+  while (list_size(polygon) > MIN_POLYGON_VERTICES) {
+    size_t count = list_size(polygon);
+    size_t best = 0;
+    double best_deviation = INFINITY;
+    for (size_t i = 0; i < count; i++) {
+      double deviation =
+          polygon_chord_deviation(original, size, kept[(i + count - 1) % count],
+                                  kept[(i + 1) % count]);
+      if (deviation < best_deviation) {
+        best_deviation = deviation;
+        best = i;
+      }
+    }
+    if (best_deviation >= tolerance) {
+      break;
+    }
+    free(list_remove(polygon, best));
+    for (size_t i = best; i + 1 < count; i++) {
+      kept[i] = kept[i + 1];
+    }
+  }
+  free(original);
+  free(kept);
+}
+
+aabb_t polygon_bounds(list_t *polygon) {
+  vector_t first = *((vector_t *)list_get(polygon, 0));
+  aabb_t bounds = {.min = first, .max = first};
+  for (size_t i = 1; i < list_size(polygon); i++) {
+    vector_t curr = *((vector_t *)list_get(polygon, i));
+    bounds.min.x = fmin(bounds.min.x, curr.x);
+    bounds.min.y = fmin(bounds.min.y, curr.y);
+    bounds.max.x = fmax(bounds.max.x, curr.x);
+    bounds.max.y = fmax(bounds.max.y, curr.y);
+  }
+  return bounds;
+}
+
+bool aabb_overlap(aabb_t a, aabb_t b) {
+  return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y &&
+         b.min.y <= a.max.y;
+}
+
+aabb_t aabb_union(aabb_t a, aabb_t b) {
+  return (aabb_t){.min = {fmin(a.min.x, b.min.x), fmin(a.min.y, b.min.y)},
+                  .max = {fmax(a.max.x, b.max.x), fmax(a.max.y, b.max.y)}};
+}
+
+aabb_t aabb_translate(aabb_t box, vector_t translation) {
+  return (aabb_t){.min = vec_add(box.min, translation),
+                  .max = vec_add(box.max, translation)};
 }
 
 void polygon_translate(list_t *polygon, vector_t translation) {
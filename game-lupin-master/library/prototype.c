@@ -0,0 +1,272 @@
+#include "prototype.h"
+#include "list.h"
+#include "polygon.h"
+#include "shapes.h"
+#include "vector.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const size_t INIT_REGISTRY_SIZE = 8;
+// Registered shapes may lose vertices that move the outline by under a pixel
+static const double PROTOTYPE_TOLERANCE = 0.5;
+
+typedef enum { PROTO_CUSTOM, PROTO_RECT, PROTO_ELLIPSE } prototype_kind_t;
+
+typedef struct prototype {
+  vector_t *vertices;
+  size_t size;
+  double area;
+  double radius;
+  aabb_t bounds;
+  size_t refs;
+  prototype_kind_t kind;
+  double params[3];
+  // Vertex indices, three per triangle, or NULL until first requested
+  int *triangles;
+  size_t triangle_indices;
+} prototype_t;
+
+/**
+ * Every interned (rect or ellipse) prototype that is currently referenced.
+ * Prototypes are removed when their last reference is released.
+ */
+static list_t *registry = NULL;
+
+prototype_t *prototype_init(list_t *shape, vector_t *centroid) {
+  prototype_t *proto = malloc(sizeof(prototype_t));
+  assert(proto != NULL);
+  polygon_props_t props = polygon_properties(shape);
+  proto->size = list_size(shape);
+  proto->vertices = malloc(sizeof(vector_t) * proto->size);
+  assert(proto->vertices != NULL);
+  for (size_t i = 0; i < proto->size; i++) {
+    proto->vertices[i] =
+        vec_subtract(*((vector_t *)list_get(shape, i)), props.centroid);
+  }
+  list_free(shape);
+
+  vector_t offset = vec_negate(props.centroid);
+  proto->area = props.area;
+  proto->bounds = aabb_translate(props.bounds, offset);
+  proto->radius = 0;
+  for (size_t i = 0; i < proto->size; i++) {
+    double dist = vec_magnitude(proto->vertices[i]);
+    if (dist > proto->radius) {
+      proto->radius = dist;
+    }
+  }
+  proto->refs = 1;
+  proto->kind = PROTO_CUSTOM;
+  proto->triangles = NULL;
+  proto->triangle_indices = 0;
+  if (centroid != NULL) {
+    *centroid = props.centroid;
+  }
+  return proto;
+}
+
+prototype_t *prototype_init_convex(list_t *shape, double tolerance,
+                                   vector_t *centroid) {
+  list_t *hull = polygon_convex_hull(shape);
+  list_free(shape);
+  polygon_simplify(hull, tolerance);
+  return prototype_init(hull, centroid);
+}
+
+/**
+ * Looks up an interned prototype by its construction parameters.
+ * Returns NULL if no matching prototype is currently alive.
+ */
+prototype_t *prototype_find(prototype_kind_t kind, double p0, double p1,
+                            double p2) {
+  if (registry == NULL) {
+    return NULL;
+  }
+  for (size_t i = 0; i < list_size(registry); i++) {
+    prototype_t *proto = list_get(registry, i);
+    if (proto->kind == kind && proto->params[0] == p0 &&
+        proto->params[1] == p1 && proto->params[2] == p2) {
+      return proto;
+    }
+  }
+  return NULL;
+}
+
+void prototype_intern(prototype_t *proto, prototype_kind_t kind, double p0,
+                      double p1, double p2) {
+  if (registry == NULL) {
+    registry = list_init(INIT_REGISTRY_SIZE, NULL);
+  }
+  proto->kind = kind;
+  proto->params[0] = p0;
+  proto->params[1] = p1;
+  proto->params[2] = p2;
+  list_add(registry, proto);
+}
+
+prototype_t *prototype_rect(double width, double height) {
+  prototype_t *proto = prototype_find(PROTO_RECT, width, height, 0);
+  if (proto != NULL) {
+    return prototype_retain(proto);
+  }
+  proto = prototype_init_convex(make_rect(width, height), PROTOTYPE_TOLERANCE,
+                                NULL);
+  prototype_intern(proto, PROTO_RECT, width, height, 0);
+  return proto;
+}
+
+prototype_t *prototype_ellipse(double axisa, double axisb, size_t vertices) {
+  prototype_t *proto = prototype_find(PROTO_ELLIPSE, axisa, axisb, vertices);
+  if (proto != NULL) {
+    return prototype_retain(proto);
+  }
+  proto = prototype_init_convex(make_ellipse(axisa, axisb, vertices),
+                                PROTOTYPE_TOLERANCE, NULL);
+  prototype_intern(proto, PROTO_ELLIPSE, axisa, axisb, vertices);
+  return proto;
+}
+
+prototype_t *prototype_retain(prototype_t *proto) {
+  proto->refs++;
+  return proto;
+}
+
+void prototype_release(prototype_t *proto) {
+  assert(proto->refs > 0);
+  proto->refs--;
+  if (proto->refs > 0) {
+    return;
+  }
+  if (proto->kind != PROTO_CUSTOM) {
+    for (size_t i = 0; i < list_size(registry); i++) {
+      if (list_get(registry, i) == proto) {
+        list_remove(registry, i);
+        break;
+      }
+    }
+    if (list_size(registry) == 0) {
+      list_free(registry);
+      registry = NULL;
+    }
+  }
+  free(proto->vertices);
+  free(proto->triangles);
+  free(proto);
+}
+
+size_t prototype_size(prototype_t *proto) { return proto->size; }
+
+vector_t prototype_get_vertex(prototype_t *proto, size_t index) {
+  assert(index < proto->size);
+  return proto->vertices[index];
+}
+
+/**
+ * Checks whether the vertices of a polygon only turn left (or go straight),
+ * in which case any vertex can see every other one.
+ */
+bool prototype_is_convex(prototype_t *proto) {
+  for (size_t i = 0; i < proto->size; i++) {
+    vector_t a = proto->vertices[i];
+    vector_t b = proto->vertices[(i + 1) % proto->size];
+    vector_t c = proto->vertices[(i + 2) % proto->size];
+    if (vec_cross(vec_subtract(b, a), vec_subtract(c, b)) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Checks whether a point lies inside or on the counterclockwise triangle abc.
+ */
+bool triangle_contains(vector_t a, vector_t b, vector_t c, vector_t p) {
+  return vec_cross(vec_subtract(b, a), vec_subtract(p, a)) >= 0 &&
+         vec_cross(vec_subtract(c, b), vec_subtract(p, b)) >= 0 &&
+         vec_cross(vec_subtract(a, c), vec_subtract(p, c)) >= 0;
+}
+
+/**
+ * Splits a concave polygon into triangles by repeatedly clipping off an
+ * ear: a convex corner whose triangle holds no other remaining vertex.
+ * Returns the number of indices written, which is short of a full
+ * triangulation only if the polygon is degenerate (e.g. self-intersecting).
+ */
+size_t prototype_clip_ears(prototype_t *proto, int *triangles) {
+  size_t remaining = proto->size, written = 0;
+  int *polygon = malloc(sizeof(int) * remaining);
+  assert(polygon != NULL);
+  for (size_t i = 0; i < remaining; i++) {
+    polygon[i] = i;
+  }
+  while (remaining > 3) {
+    size_t ear = remaining;
+    for (size_t i = 0; i < remaining && ear == remaining; i++) {
+      vector_t a = proto->vertices[polygon[(i + remaining - 1) % remaining]];
+      vector_t b = proto->vertices[polygon[i]];
+      vector_t c = proto->vertices[polygon[(i + 1) % remaining]];
+      if (vec_cross(vec_subtract(b, a), vec_subtract(c, b)) <= 0) {
+        continue;
+      }
+      ear = i;
+      for (size_t j = 0; j < remaining; j++) {
+        vector_t p = proto->vertices[polygon[j]];
+        if (j != i && j != (i + 1) % remaining &&
+            j != (i + remaining - 1) % remaining &&
+            triangle_contains(a, b, c, p)) {
+          ear = remaining;
+          break;
+        }
+      }
+    }
+    if (ear == remaining) {
+      break;
+    }
+    triangles[written++] = polygon[(ear + remaining - 1) % remaining];
+    triangles[written++] = polygon[ear];
+    triangles[written++] = polygon[(ear + 1) % remaining];
+    for (size_t i = ear; i + 1 < remaining; i++) {
+      polygon[i] = polygon[i + 1];
+    }
+    remaining--;
+  }
+  if (remaining == 3) {
+    triangles[written++] = polygon[0];
+    triangles[written++] = polygon[1];
+    triangles[written++] = polygon[2];
+  }
+  free(polygon);
+  return written;
+}
+
+const int *prototype_get_triangles(prototype_t *proto, size_t *count) {
+  if (proto->triangles == NULL && proto->size >= 3) {
+    size_t indices = (proto->size - 2) * 3;
+    proto->triangles = malloc(sizeof(int) * indices);
+    assert(proto->triangles != NULL);
+    size_t written = 0;
+    if (!prototype_is_convex(proto)) {
+      written = prototype_clip_ears(proto, proto->triangles);
+    }
+    // Convex polygons, and degenerate ones ear clipping gives up on,
+    // are fanned out from their first vertex
+    if (written < indices) {
+      written = 0;
+      for (size_t i = 1; i + 1 < proto->size; i++) {
+        proto->triangles[written++] = 0;
+        proto->triangles[written++] = i;
+        proto->triangles[written++] = i + 1;
+      }
+    }
+    proto->triangle_indices = written;
+  }
+  *count = proto->triangle_indices;
+  return proto->triangles;
+}
+
+double prototype_get_area(prototype_t *proto) { return proto->area; }
+
+double prototype_get_radius(prototype_t *proto) { return proto->radius; }
+
+aabb_t prototype_get_bounds(prototype_t *proto) { return proto->bounds; }
@@ -0,0 +1,94 @@
+#include "quad_batch.h"
+#include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdlib.h>
+
+static const size_t INIT_BATCH_QUADS = 64;
+static const size_t VERTICES_PER_QUAD = 4;
+static const size_t INDICES_PER_QUAD = 6;
+
+typedef struct quad_batch {
+  SDL_Vertex *vertices;
+  int *indices;
+  size_t size;
+  size_t capacity;
+} quad_batch_t;
+
+/**
+ * Grows a batch to hold at least the given number of quads.
+ * Indices only depend on a quad's position in the batch,
+ * so they are written once here rather than for every quad added.
+ */
+void quad_batch_reserve(quad_batch_t *batch, size_t quads) {
+  if (quads <= batch->capacity) {
+    return;
+  }
+  size_t capacity = batch->capacity > 0 ? batch->capacity : INIT_BATCH_QUADS;
+  while (capacity < quads) {
+    capacity *= 2;
+  }
+  batch->vertices = realloc(batch->vertices,
+                            sizeof(SDL_Vertex) * capacity * VERTICES_PER_QUAD);
+  assert(batch->vertices != NULL);
+  batch->indices =
+      realloc(batch->indices, sizeof(int) * capacity * INDICES_PER_QUAD);
+  assert(batch->indices != NULL);
+  for (size_t i = batch->capacity; i < capacity; i++) {
+    int first = i * VERTICES_PER_QUAD;
+    int *quad = batch->indices + i * INDICES_PER_QUAD;
+    quad[0] = first;
+    quad[1] = first + 1;
+    quad[2] = first + 2;
+    quad[3] = first;
+    quad[4] = first + 2;
+    quad[5] = first + 3;
+  }
+  batch->capacity = capacity;
+}
+
+quad_batch_t *quad_batch_init(void) {
+  quad_batch_t *batch = malloc(sizeof(quad_batch_t));
+  assert(batch != NULL);
+  batch->vertices = NULL;
+  batch->indices = NULL;
+  batch->size = 0;
+  batch->capacity = 0;
+  quad_batch_reserve(batch, INIT_BATCH_QUADS);
+  return batch;
+}
+
+void quad_batch_free(quad_batch_t *batch) {
+  free(batch->vertices);
+  free(batch->indices);
+  free(batch);
+}
+
+void quad_batch_add(quad_batch_t *batch, SDL_Rect dst, SDL_Rect src,
+                    int texture_width, int texture_height, SDL_Color color) {
+  quad_batch_reserve(batch, batch->size + 1);
+  SDL_Vertex *quad = batch->vertices + batch->size * VERTICES_PER_QUAD;
+  float x0 = dst.x, y0 = dst.y;
+  float x1 = x0 + dst.w, y1 = y0 + dst.h;
+  float u0 = (float)src.x / texture_width;
+  float v0 = (float)src.y / texture_height;
+  float u1 = (float)(src.x + src.w) / texture_width;
+  float v1 = (float)(src.y + src.h) / texture_height;
+  quad[0] = (SDL_Vertex){{x0, y0}, color, {u0, v0}};
+  quad[1] = (SDL_Vertex){{x1, y0}, color, {u1, v0}};
+  quad[2] = (SDL_Vertex){{x1, y1}, color, {u1, v1}};
+  quad[3] = (SDL_Vertex){{x0, y1}, color, {u0, v1}};
+  batch->size++;
+}
+
+size_t quad_batch_size(quad_batch_t *batch) { return batch->size; }
+
+void quad_batch_flush(quad_batch_t *batch, SDL_Renderer *renderer,
+                      SDL_Texture *texture) {
+  if (batch->size == 0) {
+    return;
+  }
+  SDL_RenderGeometry(renderer, texture, batch->vertices,
+                     batch->size * VERTICES_PER_QUAD, batch->indices,
+                     batch->size * INDICES_PER_QUAD);
+  batch->size = 0;
+}
@@ -0,0 +1,106 @@
+#include "query.h"
+#include "body.h"
+#include "vector.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Either a body's current shape or a plain array of vertices */
+typedef struct shape_view {
+  body_t *body;
+  const vector_t *points;
+  size_t size;
+} shape_view_t;
+
+bool query_matches(body_t *body, uint32_t mask) {
+  return mask == UINT32_MAX || (body_get_category(body) & mask) != 0;
+}
+
+shape_view_t query_view_body(body_t *body) {
+  return (shape_view_t){
+      .body = body, .points = NULL, .size = body_get_vertex_count(body)};
+}
+
+vector_t query_vertex(shape_view_t *shape, size_t index) {
+  return shape->body != NULL ? body_get_vertex(shape->body, index)
+                             : shape->points[index];
+}
+
+/** Projects a shape onto an axis, as the interval {min, max} */
+vector_t query_project(shape_view_t *shape, vector_t axis) {
+  double min = INFINITY;
+  double max = -INFINITY;
+  for (size_t i = 0; i < shape->size; i++) {
+    double proj = vec_dot(query_vertex(shape, i), axis);
+    min = fmin(min, proj);
+    max = fmax(max, proj);
+  }
+  return (vector_t){min, max};
+}
+
+bool query_sweep(shape_view_t *moving, vector_t translation,
+                 shape_view_t *target, cast_hit_t *hit) {
+  double enter = -INFINITY;
+  double exit = INFINITY;
+  vector_t enter_axis = VEC_ZERO;
+  shape_view_t *shapes[] = {moving, target};
+  for (size_t s = 0; s < 2; s++) {
+    shape_view_t *shape = shapes[s];
+    for (size_t i = 0; i < shape->size; i++) {
+      vector_t edge = vec_subtract(query_vertex(shape, (i + 1) % shape->size),
+                                   query_vertex(shape, i));
+      if (edge.x == 0 && edge.y == 0) {
+        continue;
+      }
+      vector_t axis = vec_normalize((vector_t){-edge.y, edge.x});
+      vector_t a = query_project(moving, axis);
+      vector_t b = query_project(target, axis);
+      double speed = vec_dot(translation, axis);
+      if (speed == 0) {
+        if (a.y < b.x || a.x > b.y) {
+          return false;
+        }
+        continue;
+      }
+      double t0;
+      double t1;
+      vector_t toward;
+      if (speed > 0) {
+        t0 = (b.x - a.y) / speed;
+        t1 = (b.y - a.x) / speed;
+        toward = axis;
+      } else {
+        t0 = (b.y - a.x) / speed;
+        t1 = (b.x - a.y) / speed;
+        toward = vec_negate(axis);
+      }
+      if (t0 > enter) {
+        enter = t0;
+        enter_axis = toward;
+      }
+      exit = fmin(exit, t1);
+      if (enter > exit || enter > 1 || exit < 0) {
+        return false;
+      }
+    }
+  }
+  hit->body = target->body;
+  hit->fraction = fmax(enter, 0);
+  hit->normal = enter > 0 ? vec_negate(enter_axis) : VEC_ZERO;
+  return true;
+}
+
+bool query_cast_points(const vector_t *points, size_t size,
+                       vector_t translation, body_t *body, cast_hit_t *hit) {
+  shape_view_t moving = {.body = NULL, .points = points, .size = size};
+  shape_view_t target = query_view_body(body);
+  return query_sweep(&moving, translation, &target, hit);
+}
+
+bool query_cast_body(body_t *shape, vector_t translation, body_t *body,
+                     cast_hit_t *hit) {
+  shape_view_t moving = query_view_body(shape);
+  shape_view_t target = query_view_body(body);
+  return query_sweep(&moving, translation, &target, hit);
+}
@@ -0,0 +1,151 @@
+#include "render_queue.h"
+#include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t INIT_QUEUE_SIZE = 64;
+static const size_t INIT_TEXTURES_SIZE = 8;
+// Sort key layout, from the most significant bit down
+static const int LAYER_SHIFT = 56;
+static const int BLEND_SHIFT = 52;
+static const uint64_t BLEND_MASK = 0xF;
+static const int TEXTURE_SHIFT = 32;
+static const uint64_t TEXTURE_MASK = 0xFFFFF;
+static const uint64_t SEQUENCE_MASK = 0xFFFFFFFF;
+// The radix sort handles a byte of the key per pass
+static const size_t RADIX_BITS = 8;
+static const size_t RADIX_BUCKETS = 256;
+
+typedef struct render_queue {
+  render_command_t *commands;
+  // The sort key of each command, in sorted order once sorted.
+  // The low bits of a key are the index of its command.
+  uint64_t *keys;
+  uint64_t *scratch;
+  size_t size;
+  size_t capacity;
+  // The textures seen this frame; a texture's id is its index plus one
+  SDL_Texture **textures;
+  size_t texture_count;
+  size_t texture_capacity;
+} render_queue_t;
+
+render_queue_t *render_queue_init(void) {
+  render_queue_t *queue = malloc(sizeof(render_queue_t));
+  assert(queue != NULL);
+  queue->capacity = INIT_QUEUE_SIZE;
+  queue->commands = malloc(sizeof(render_command_t) * queue->capacity);
+  assert(queue->commands != NULL);
+  queue->keys = malloc(sizeof(uint64_t) * queue->capacity);
+  assert(queue->keys != NULL);
+  queue->scratch = malloc(sizeof(uint64_t) * queue->capacity);
+  assert(queue->scratch != NULL);
+  queue->size = 0;
+  queue->texture_capacity = INIT_TEXTURES_SIZE;
+  queue->textures = malloc(sizeof(SDL_Texture *) * queue->texture_capacity);
+  assert(queue->textures != NULL);
+  queue->texture_count = 0;
+  return queue;
+}
+
+void render_queue_free(render_queue_t *queue) {
+  free(queue->commands);
+  free(queue->keys);
+  free(queue->scratch);
+  free(queue->textures);
+  free(queue);
+}
+
+void render_queue_clear(render_queue_t *queue) {
+  queue->size = 0;
+  queue->texture_count = 0;
+}
+
+/**
+ * Gets the id of a texture for this frame, giving it the next id
+ * the first time it is seen. Untextured commands have id 0.
+ */
+uint64_t render_queue_texture_id(render_queue_t *queue, SDL_Texture *texture) {
+  if (texture == NULL) {
+    return 0;
+  }
+  for (size_t i = 0; i < queue->texture_count; i++) {
+    if (queue->textures[i] == texture) {
+      return i + 1;
+    }
+  }
+  if (queue->texture_count == queue->texture_capacity) {
+    queue->texture_capacity *= 2;
+    queue->textures = realloc(queue->textures, sizeof(SDL_Texture *) *
+                                                   queue->texture_capacity);
+    assert(queue->textures != NULL);
+  }
+  queue->textures[queue->texture_count++] = texture;
+  assert(queue->texture_count <= TEXTURE_MASK);
+  return queue->texture_count;
+}
+
+void render_queue_push(render_queue_t *queue, render_layer_t layer,
+                       SDL_BlendMode blend, render_command_t command) {
+  if (queue->size == queue->capacity) {
+    queue->capacity *= 2;
+    queue->commands = realloc(queue->commands,
+                              sizeof(render_command_t) * queue->capacity);
+    assert(queue->commands != NULL);
+    queue->keys = realloc(queue->keys, sizeof(uint64_t) * queue->capacity);
+    assert(queue->keys != NULL);
+    queue->scratch =
+        realloc(queue->scratch, sizeof(uint64_t) * queue->capacity);
+    assert(queue->scratch != NULL);
+  }
+  assert(queue->size <= SEQUENCE_MASK);
+  uint64_t texture_id = render_queue_texture_id(queue, command.texture);
+  queue->keys[queue->size] = (uint64_t)layer << LAYER_SHIFT |
+                             ((uint64_t)blend & BLEND_MASK) << BLEND_SHIFT |
+                             texture_id << TEXTURE_SHIFT | queue->size;
+  queue->commands[queue->size] = command;
+  queue->size++;
+}
+
+void render_queue_sort(render_queue_t *queue) {
+  size_t counts[RADIX_BUCKETS];
+  uint64_t *keys = queue->keys, *scratch = queue->scratch;
+  for (size_t shift = 0; shift < sizeof(uint64_t) * 8; shift += RADIX_BITS) {
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < queue->size; i++) {
+      counts[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+    }
+    // Every key has the same byte here, so this pass would not move any
+    if (queue->size == 0 ||
+        counts[(keys[0] >> shift) & (RADIX_BUCKETS - 1)] == queue->size) {
+      continue;
+    }
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+      size_t count = counts[bucket];
+      counts[bucket] = offset;
+      offset += count;
+    }
+    for (size_t i = 0; i < queue->size; i++) {
+      scratch[counts[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++] = keys[i];
+    }
+    uint64_t *sorted = scratch;
+    scratch = keys;
+    keys = sorted;
+  }
+  queue->keys = keys;
+  queue->scratch = scratch;
+}
+
+size_t render_queue_size(render_queue_t *queue) { return queue->size; }
+
+render_command_t *render_queue_get(render_queue_t *queue, size_t index) {
+  assert(index < queue->size);
+  return &queue->commands[queue->keys[index] & SEQUENCE_MASK];
+}
+
+size_t render_queue_textures(render_queue_t *queue) {
+  return queue->texture_count;
+}
@@ -1,11 +1,18 @@
 #include "scene.h"
 #include "body.h"
+#include "broadphase.h"
 #include "forces.h"
+#include "integrator.h"
+#include "island.h"
 #include "list.h"
 #include "polygon.h"
+#include "query.h"
 #include "sdl_wrapper.h"
+#include "solver.h"
 #include "sprite.h"
 #include "text.h"
+#include "texture_cache.h"
+#include "toi.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 #include <SDL2/SDL_image.h>
@@ -13,7 +20,9 @@
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_ttf.h>
 #include <assert.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -24,9 +33,14 @@ const size_t INIT_REMOVE_FORCES_SIZE = 5;
 const size_t INIT_NOISES_SIZE = 10;
 const size_t INIT_SETTING_SIZE = 10;
 const size_t INIT_TEXTS_SIZE = 1;
+// Fraction of its own thickness a body may travel in one substep
+static const double CFL_NUMBER = 0.5;
+static const size_t MAX_SUBSTEPS = 8;
 
 typedef struct scene {
+  // the bodies, in the same order as their states in pool
   list_t *bodies;
+  body_pool_t *pool;
   list_t *forces;
   void *player_info;
   int curr_lvl;
@@ -35,14 +49,48 @@ typedef struct scene {
   list_t *noises;
   list_t *setting;
   list_t *texts;
+  solver_t *solver;
+  islands_t *islands;
+  broadphase_t *broadphase;
+  double dt;
+  integrator_t integrator;
+  integration_t *integration;
+  size_t last_substeps;
+  scene_mode_t mode;
+  toi_t *toi;
+  size_t reorder_interval;
+  size_t ticks_since_reorder;
 } scene_t;
 
 typedef void (*force_creator_t)(void *aux);
 
+/**
+ * A query in progress: what is being searched for and where results go.
+ * Exactly one of the callbacks or buffers is used, or neither when only the
+ * closest hit is wanted.
+ */
+typedef struct scene_query {
+  uint32_t mask;
+  const vector_t *points;
+  size_t size;
+  body_t *shape;
+  vector_t origin;
+  vector_t translation;
+  query_callback_t body_callback;
+  cast_callback_t cast_callback;
+  void *aux;
+  body_t **bodies;
+  cast_hit_t *hits;
+  size_t capacity;
+  size_t count;
+  cast_hit_t closest;
+} scene_query_t;
+
 scene_t *scene_init(void) {
   scene_t *scene = malloc(sizeof(scene_t));
   assert(scene != NULL);
   scene->bodies = list_init(INIT_BODIES_SIZE, (free_func_t)body_free);
+  scene->pool = body_pool_init();
   scene->forces = list_init(INIT_FORCES_SIZE, (free_func_t)force_free);
   scene->player_info = NULL;
   scene->curr_lvl = 1;
@@ -51,15 +99,33 @@ scene_t *scene_init(void) {
   scene->noises = list_init(INIT_NOISES_SIZE, (free_func_t)NULL);
   scene->setting = list_init(INIT_SETTING_SIZE, (free_func_t)NULL);
   scene->texts = list_init(INIT_TEXTS_SIZE, (free_func_t)text_free);
+  scene->solver = solver_init();
+  scene->islands = islands_init();
+  scene->broadphase = broadphase_init();
+  scene->dt = 0;
+  scene->integrator = INTEGRATOR_AVERAGE;
+  scene->integration = integration_init();
+  scene->last_substeps = 0;
+  scene->mode = SCENE_MODE_STEPPED;
+  scene->toi = toi_init();
+  scene->reorder_interval = 0;
+  scene->ticks_since_reorder = 0;
   return scene;
 }
 
 void scene_free(scene_t *scene) {
   list_free(scene->forces);
+  // the bodies' states live in the pool, so free them first
   list_free(scene->bodies);
+  body_pool_free(scene->pool);
   list_free(scene->setting);
   sprite_free(scene->sprite_info);
   list_free(scene->texts);
+  solver_free(scene->solver);
+  islands_free(scene->islands);
+  broadphase_free(scene->broadphase);
+  integration_free(scene->integration);
+  toi_free(scene->toi);
   // for (int n=0; n < sizeof(scene->noises); n++){
   //   Mix_FreeChunk(list_get(scene->noises,n));
   // };
@@ -76,6 +142,8 @@ body_t *scene_get_body(scene_t *scene, size_t index) {
 
 void scene_add_body(scene_t *scene, body_t *body) {
   list_add(scene->bodies, body);
+  body_pool_add(scene->pool, body);
+  broadphase_add_body(scene->broadphase, body);
 }
 
 void scene_remove_body(scene_t *scene, size_t index) {
@@ -119,8 +187,10 @@ void scene_set_texture(scene_t *scene, const char *texture_file) {
 
 void scene_set_texture_scaled(scene_t *scene, const char *texture_file,
                               double scaling) {
-  SDL_Texture *texture = sdl_create_texture(texture_file);
+  SDL_Rect region;
+  SDL_Texture *texture = texture_cache_acquire(texture_file, &region);
   sprite_set_texture_scaled(scene->sprite_info, texture, scaling);
+  sprite_set_region(scene->sprite_info, region);
 }
 
 bool scene_has_sprite(scene_t *scene) {
@@ -158,7 +228,7 @@ void scene_add_text(scene_t *scene, text_t *text) {
 }
 
 void scene_remove_text(scene_t *scene, size_t idx) {
-  list_remove(scene->texts, idx);
+  text_free(list_remove(scene->texts, idx));
 }
 
 void scene_update_text(scene_t *scene, size_t idx, char *content) {
@@ -167,15 +237,297 @@ void scene_update_text(scene_t *scene, size_t idx, char *content) {
 
 size_t scene_get_texts_count(scene_t *scene) { return list_size(scene->texts); }
 
-// have not updated this
-void scene_tick(scene_t *scene, double dt) {
-  for (size_t i = 0; i < list_size(scene->forces); i++) {
-    force_t *f_at_ind = list_get(scene->forces, i);
-    apply_force_creator(f_at_ind);
+solver_t *scene_get_solver(scene_t *scene) { return scene->solver; }
+
+void scene_add_collision_rule(scene_t *scene, uint32_t category1,
+                              uint32_t category2, double elasticity) {
+  broadphase_add_rule(scene->broadphase, category1, category2, elasticity,
+                      NULL, NULL, NULL);
+}
+
+void scene_add_collision_handler_rule(scene_t *scene, uint32_t category1,
+                                      uint32_t category2,
+                                      collision_handler_t handler, void *aux,
+                                      free_func_t freer) {
+  broadphase_add_rule(scene->broadphase, category1, category2, 0, handler, aux,
+                      freer);
+}
+
+broadphase_t *scene_get_broadphase(scene_t *scene) {
+  return scene->broadphase;
+}
+
+size_t scene_trigger_events(scene_t *scene) {
+  return broadphase_events(scene->broadphase);
+}
+
+trigger_event_t scene_get_trigger_event(scene_t *scene, size_t index) {
+  return broadphase_get_event(scene->broadphase, index);
+}
+
+double scene_get_dt(scene_t *scene) { return scene->dt; }
+
+void scene_set_integrator(scene_t *scene, integrator_t integrator) {
+  scene->integrator = integrator;
+}
+
+integrator_t scene_get_integrator(scene_t *scene) { return scene->integrator; }
+
+size_t scene_get_last_substeps(scene_t *scene) { return scene->last_substeps; }
+
+size_t scene_islands(scene_t *scene) { return islands_count(scene->islands); }
+
+void scene_set_mode(scene_t *scene, scene_mode_t mode) {
+  scene->mode = mode;
+  toi_invalidate(scene->toi);
+}
+
+scene_mode_t scene_get_mode(scene_t *scene) { return scene->mode; }
+
+size_t scene_get_last_impacts(scene_t *scene) {
+  return toi_last_impacts(scene->toi);
+}
+
+void scene_reorder_bodies(scene_t *scene) {
+  body_pool_sort(scene->pool);
+  // the bodies list follows the pool, so loops over it walk the pool in
+  // order; the per-tick integrator and island arrays are indexed by it too
+  while (list_size(scene->bodies) > 0) {
+    list_remove_last(scene->bodies);
+  }
+  for (size_t i = 0; i < body_pool_size(scene->pool); i++) {
+    list_add(scene->bodies, body_pool_get(scene->pool, i));
+  }
+  // the impact queue refers to bodies by index
+  toi_invalidate(scene->toi);
+  scene->ticks_since_reorder = 0;
+}
+
+void scene_set_reorder_interval(scene_t *scene, size_t ticks) {
+  scene->reorder_interval = ticks;
+  scene->ticks_since_reorder = 0;
+}
+
+/** Tests a broad phase candidate and hands it to the query's destination */
+bool scene_query_visit(body_t *body, scene_query_t *query) {
+  if (body == query->shape || body_is_removed(body) ||
+      !query_matches(body, query->mask)) {
+    return true;
+  }
+  cast_hit_t hit;
+  bool touching =
+      query->shape != NULL
+          ? query_cast_body(query->shape, query->translation, body, &hit)
+          : query_cast_points(query->points, query->size, query->translation,
+                              body, &hit);
+  if (!touching) {
+    return true;
+  }
+  hit.point =
+      vec_add(query->origin, vec_multiply(hit.fraction, query->translation));
+  if (query->body_callback != NULL) {
+    query->count++;
+    return query->body_callback(body, query->aux);
+  }
+  if (query->cast_callback != NULL) {
+    query->count++;
+    return query->cast_callback(hit, query->aux);
+  }
+  if (query->bodies != NULL) {
+    query->bodies[query->count++] = body;
+    return query->count < query->capacity;
+  }
+  if (query->hits != NULL) {
+    query->hits[query->count++] = hit;
+    return query->count < query->capacity;
+  }
+  if (query->count == 0 || hit.fraction < query->closest.fraction) {
+    query->closest = hit;
+  }
+  query->count = 1;
+  return true;
+}
+
+scene_query_t scene_query_init(uint32_t mask) {
+  return (scene_query_t){.mask = mask,
+                         .points = NULL,
+                         .size = 0,
+                         .shape = NULL,
+                         .origin = VEC_ZERO,
+                         .translation = VEC_ZERO,
+                         .body_callback = NULL,
+                         .cast_callback = NULL,
+                         .aux = NULL,
+                         .bodies = NULL,
+                         .hits = NULL,
+                         .capacity = 0,
+                         .count = 0};
+}
+
+/** Runs a query over the bodies whose boxes overlap its swept bounds */
+size_t scene_query_run(scene_t *scene, scene_query_t *query) {
+  if (query->capacity == 0 && (query->bodies != NULL || query->hits != NULL)) {
+    return 0;
+  }
+  aabb_t box;
+  if (query->shape != NULL) {
+    box = body_get_bounds(query->shape);
+  } else {
+    box = (aabb_t){query->points[0], query->points[0]};
+    for (size_t i = 1; i < query->size; i++) {
+      box = aabb_union(box, (aabb_t){query->points[i], query->points[i]});
+    }
+  }
+  box = aabb_union(box, aabb_translate(box, query->translation));
+  broadphase_query(scene->broadphase, box,
+                   (broadphase_query_t)scene_query_visit, query);
+  return query->count;
+}
+
+size_t scene_query_aabb(scene_t *scene, aabb_t box, uint32_t mask,
+                        query_callback_t callback, void *aux) {
+  vector_t corners[] = {box.min,
+                        {box.max.x, box.min.y},
+                        box.max,
+                        {box.min.x, box.max.y}};
+  scene_query_t query = scene_query_init(mask);
+  query.points = corners;
+  query.size = 4;
+  query.body_callback = callback;
+  query.aux = aux;
+  return scene_query_run(scene, &query);
+}
+
+size_t scene_query_aabb_buffer(scene_t *scene, aabb_t box, uint32_t mask,
+                               body_t **bodies, size_t capacity) {
+  vector_t corners[] = {box.min,
+                        {box.max.x, box.min.y},
+                        box.max,
+                        {box.min.x, box.max.y}};
+  scene_query_t query = scene_query_init(mask);
+  query.points = corners;
+  query.size = 4;
+  query.bodies = bodies;
+  query.capacity = capacity;
+  return scene_query_run(scene, &query);
+}
+
+size_t scene_query_point(scene_t *scene, vector_t point, uint32_t mask,
+                         query_callback_t callback, void *aux) {
+  scene_query_t query = scene_query_init(mask);
+  query.points = &point;
+  query.size = 1;
+  query.body_callback = callback;
+  query.aux = aux;
+  return scene_query_run(scene, &query);
+}
+
+size_t scene_query_point_buffer(scene_t *scene, vector_t point, uint32_t mask,
+                                body_t **bodies, size_t capacity) {
+  scene_query_t query = scene_query_init(mask);
+  query.points = &point;
+  query.size = 1;
+  query.bodies = bodies;
+  query.capacity = capacity;
+  return scene_query_run(scene, &query);
+}
+
+bool scene_raycast(scene_t *scene, vector_t origin, vector_t translation,
+                   uint32_t mask, cast_hit_t *hit) {
+  scene_query_t query = scene_query_init(mask);
+  query.points = &origin;
+  query.size = 1;
+  query.origin = origin;
+  query.translation = translation;
+  if (scene_query_run(scene, &query) == 0) {
+    return false;
+  }
+  *hit = query.closest;
+  return true;
+}
+
+size_t scene_raycast_all(scene_t *scene, vector_t origin, vector_t translation,
+                         uint32_t mask, cast_callback_t callback, void *aux) {
+  scene_query_t query = scene_query_init(mask);
+  query.points = &origin;
+  query.size = 1;
+  query.origin = origin;
+  query.translation = translation;
+  query.cast_callback = callback;
+  query.aux = aux;
+  return scene_query_run(scene, &query);
+}
+
+size_t scene_raycast_buffer(scene_t *scene, vector_t origin,
+                            vector_t translation, uint32_t mask,
+                            cast_hit_t *hits, size_t capacity) {
+  scene_query_t query = scene_query_init(mask);
+  query.points = &origin;
+  query.size = 1;
+  query.origin = origin;
+  query.translation = translation;
+  query.hits = hits;
+  query.capacity = capacity;
+  return scene_query_run(scene, &query);
+}
+
+bool scene_shape_cast(scene_t *scene, body_t *shape, vector_t translation,
+                      uint32_t mask, cast_hit_t *hit) {
+  scene_query_t query = scene_query_init(mask);
+  query.shape = shape;
+  query.origin = body_get_centroid(shape);
+  query.translation = translation;
+  if (scene_query_run(scene, &query) == 0) {
+    return false;
   }
+  *hit = query.closest;
+  return true;
+}
+
+size_t scene_shape_cast_all(scene_t *scene, body_t *shape,
+                            vector_t translation, uint32_t mask,
+                            cast_callback_t callback, void *aux) {
+  scene_query_t query = scene_query_init(mask);
+  query.shape = shape;
+  query.origin = body_get_centroid(shape);
+  query.translation = translation;
+  query.cast_callback = callback;
+  query.aux = aux;
+  return scene_query_run(scene, &query);
+}
+
+/**
+ * Picks how many substeps a tick needs so that no awake body travels more
+ * than CFL_NUMBER times its thickness (the smaller side of its bounding box)
+ * per substep, up to MAX_SUBSTEPS.
+ */
+size_t scene_substeps(scene_t *scene, double dt) {
+  double max_ratio = 0;
   for (size_t i = 0; i < scene_bodies(scene); i++) {
-    body_tick(scene_get_body(scene, i), dt);
+    body_t *body = scene_get_body(scene, i);
+    if (body_is_sleeping(body)) {
+      continue;
+    }
+    vector_t vel = body_get_velocity(body);
+    if (vel.x == 0 && vel.y == 0) {
+      continue;
+    }
+    aabb_t bounds = body_get_bounds(body);
+    double thickness =
+        fmin(bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y);
+    double ratio = vec_magnitude(vel) * dt / (CFL_NUMBER * thickness);
+    if (ratio > max_ratio) {
+      max_ratio = ratio;
+    }
+  }
+  if (max_ratio <= 1) {
+    return 1;
   }
+  return max_ratio >= MAX_SUBSTEPS ? MAX_SUBSTEPS : (size_t)ceil(max_ratio);
+}
+
+/** Frees the bodies marked for removal and the forces acting on them */
+void scene_remove_marked(scene_t *scene) {
   list_t *to_remove_bodies =
       list_init(INIT_REMOVE_BODIES_SIZE, (free_func_t)body_free);
   list_t *to_remove_forces =
@@ -184,6 +536,9 @@ void scene_tick(scene_t *scene, double dt) {
     body_t *curr_body = scene_get_body(scene, i);
     if (body_is_removed(curr_body)) {
       list_remove(scene->bodies, i);
+      body_pool_remove(scene->pool, i);
+      broadphase_remove_body(scene->broadphase, curr_body);
+      toi_remove_body(scene->toi, curr_body);
       list_add(to_remove_bodies, curr_body);
     }
   }
@@ -201,3 +556,77 @@ void scene_tick(scene_t *scene, double dt) {
   list_free(to_remove_forces);
   list_free(to_remove_bodies);
 }
+
+/** Runs one substep: forces, collisions, integration, sleep and removal */
+void scene_step(scene_t *scene, double dt) {
+  scene->dt = dt;
+  solver_clear(scene->solver);
+  // field forces go first so the integrator can tell them apart
+  for (size_t i = 0; i < list_size(scene->forces); i++) {
+    force_t *f_at_ind = list_get(scene->forces, i);
+    if (force_is_field(f_at_ind)) {
+      apply_force_creator(f_at_ind);
+    }
+  }
+  integration_record_field_forces(scene->integration, scene->bodies);
+  for (size_t i = 0; i < list_size(scene->forces); i++) {
+    force_t *f_at_ind = list_get(scene->forces, i);
+    if (!force_is_field(f_at_ind)) {
+      apply_force_creator(f_at_ind);
+    }
+  }
+  broadphase_update(scene->broadphase, scene->solver);
+  solver_solve(scene->solver, dt);
+  integration_step(scene->integration, scene->integrator, scene->bodies,
+                   scene->forces, dt);
+  islands_update(scene->islands, scene->bodies, scene->forces, scene->solver,
+                 dt);
+  scene_remove_marked(scene);
+}
+
+/**
+ * Returns whether every body moves in a straight line at constant velocity
+ * and collides as its bounding box, so impacts can be predicted exactly
+ * (see toi.h). Bodies colliding with their pixels need the narrow phase.
+ */
+bool scene_is_ballistic(scene_t *scene) {
+  if (list_size(scene->forces) > 0) {
+    return false;
+  }
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    vector_t acc = body_get_acceleration(body);
+    if (body_get_drag(body) != 0 || body_get_rot_velocity(body) != 0 ||
+        acc.x != 0 || acc.y != 0 || body_has_pixel_collision(body)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void scene_tick(scene_t *scene, double dt) {
+  broadphase_clear_events(scene->broadphase);
+  if (scene->reorder_interval > 0 &&
+      ++scene->ticks_since_reorder >= scene->reorder_interval) {
+    scene_reorder_bodies(scene);
+  }
+  if (scene->mode == SCENE_MODE_EVENT_DRIVEN && scene_is_ballistic(scene)) {
+    scene->dt = dt;
+    dt = toi_advance(scene->toi, scene->bodies, scene->broadphase, dt);
+    scene_remove_marked(scene);
+    scene->last_substeps = 0;
+    if (dt == 0) {
+      broadphase_refresh(scene->broadphase);
+      return;
+    }
+  }
+  // stepping moves bodies behind the impact queue's back
+  toi_invalidate(scene->toi);
+  size_t substeps = scene_substeps(scene, dt);
+  for (size_t i = 0; i < substeps; i++) {
+    scene_step(scene, dt / substeps);
+  }
+  scene->last_substeps = substeps;
+  // keep the boxes current for spatial queries between ticks
+  broadphase_refresh(scene->broadphase);
+}
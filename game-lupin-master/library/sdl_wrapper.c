@@ -1,9 +1,14 @@
 #include "sdl_wrapper.h"
 #include "game.h"
 #include "game_info.h"
+#include "glyph_atlas.h"
+#include "mask.h"
+#include "quad_batch.h"
+#include "render_queue.h"
 #include "sprite.h"
 #include "state.h"
 #include "text.h"
+#include "triangle_batch.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 #include <SDL2/SDL_image.h>
@@ -19,6 +24,20 @@
 const double MS_PER_S = 1e3;
 
 const size_t POINTS_ACC_STR_SIZE = 20;
+// Pixels at least this opaque count for collisions
+const uint8_t MASK_ALPHA_THRESHOLD = 128;
+const size_t INIT_FONTS_SIZE = 4;
+const SDL_Color SPRITE_TINT = {255, 255, 255, 255};
+// FNV-1a, for fingerprinting the static layer's contents
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+typedef struct font_entry {
+  int size;
+  TTF_Font *font;
+  // NULL until a dynamic text of this size is drawn
+  glyph_atlas_t *atlas;
+} font_entry_t;
 
 /**
  * The coordinate at the center of the screen.
@@ -36,6 +55,17 @@ SDL_Window *window;
  * The renderer used to draw the scene.
  */
 SDL_Renderer *renderer;
+/**
+ * Where frames go, chosen by sdl_init_backend().
+ */
+render_backend_t backend = RENDER_BACKEND_WINDOW;
+/**
+ * The surface the software renderer draws into, or NULL for other backends.
+ * The null backend's renderer draws into a surface too, but only ever
+ * creates textures with it.
+ */
+SDL_Surface *frame_surface = NULL;
+render_stats_t render_stats;
 /**
  * The keypress handler, or NULL if none has been configured.
  */
@@ -50,18 +80,67 @@ uint32_t key_start_timestamp;
  * Initially 0.
  */
 clock_t last_clock = 0;
+/**
+ * Every size of FONT_FILE opened so far, or NULL before the first text.
+ */
+list_t *fonts = NULL;
+/**
+ * Sprites queued by sdl_queue_sprite() that have not been drawn yet,
+ * all cut from sprite_batch_texture. NULL until the first sprite is queued.
+ */
+quad_batch_t *sprite_batch = NULL;
+SDL_Texture *sprite_batch_texture = NULL;
+int sprite_batch_width, sprite_batch_height;
+/**
+ * Untextured bodies queued by sdl_queue_body() that have not been drawn yet.
+ * NULL until the first body is queued.
+ */
+triangle_batch_t *polygon_batch = NULL;
+/**
+ * The draw commands of the frame being rendered.
+ * NULL until the first frame.
+ */
+render_queue_t *frame_queue = NULL;
+/**
+ * The scene's background, static bodies (see body_set_static()) and
+ * boundary, drawn once and copied to the window every frame.
+ * NULL until the first frame, or if the renderer has no render targets.
+ */
+SDL_Texture *static_layer = NULL;
+int static_layer_width, static_layer_height;
+/**
+ * A fingerprint of what static_layer shows, so it is redrawn
+ * whenever that changes.
+ */
+uint64_t static_layer_signature;
 
-/** Computes the center of the window in pixel coordinates */
-vector_t get_window_center(void) {
-  int *width = malloc(sizeof(*width)), *height = malloc(sizeof(*height));
-  assert(width != NULL);
-  assert(height != NULL);
-  SDL_GetWindowSize(window, width, height);
-  vector_t dimensions = {.x = *width, .y = *height};
-  free(width);
-  free(height);
-  return vec_multiply(0.5, dimensions);
-}
+/**
+ * The mapping from scene coordinates to window pixels:
+ * a scene point p is drawn at (offset.x + scale * p.x, offset.y - scale * p.y).
+ */
+typedef struct view {
+  int width;
+  int height;
+  vector_t window_center;
+  double scale;
+  vector_t offset;
+} view_t;
+
+/**
+ * The current view, which is only valid while view_valid is true.
+ * It is recomputed on first use after a resize.
+ */
+view_t view;
+bool view_valid = false;
+/**
+ * The scene vertices of the polygon being queued, and the fan of triangles
+ * sdl_draw_polygon() splits it into, 3 * (scratch_capacity - 2) long.
+ * Both only grow, so queueing allocates nothing once they fit the largest
+ * polygon.
+ */
+vector_t *scratch_points = NULL;
+int *scratch_fan = NULL;
+size_t scratch_capacity = 0;
 
 /**
  * Computes the scaling factor between scene coordinates and pixel coordinates.
@@ -75,19 +154,84 @@ double get_scene_scale(vector_t window_center) {
   return x_scale < y_scale ? x_scale : y_scale;
 }
 
+void sdl_invalidate_view(void) { view_valid = false; }
+
+/** Gets the size in pixels of the frames being drawn */
+void sdl_get_output_size(int *width, int *height) {
+  if (window != NULL) {
+    SDL_GetWindowSize(window, width, height);
+  } else {
+    *width = WINDOW_WIDTH;
+    *height = WINDOW_HEIGHT;
+  }
+}
+
+/**
+ * Gets the mapping from scene to window coordinates,
+ * recomputing it if the window has been resized since it was last used.
+ */
+view_t *sdl_get_view(void) {
+  if (!view_valid) {
+    sdl_get_output_size(&view.width, &view.height);
+    view.window_center =
+        vec_multiply(0.5, (vector_t){.x = view.width, .y = view.height});
+    view.scale = get_scene_scale(view.window_center);
+    // Map the center of the scene to the center of the window,
+    // flipping the y axis since positive y is down on the screen
+    view.offset = (vector_t){.x = view.window_center.x - view.scale * center.x,
+                             .y = view.window_center.y + view.scale * center.y};
+    view_valid = true;
+  }
+  return &view;
+}
+
+/** Computes the center of the window in pixel coordinates */
+vector_t get_window_center(void) { return sdl_get_view()->window_center; }
+
 /** Maps a scene coordinate to a window coordinate */
-vector_t get_window_position(vector_t scene_pos, vector_t window_center) {
-  // Scale scene coordinates by the scaling factor
-  // and map the center of the scene to the center of the window
-  vector_t scene_center_offset = vec_subtract(scene_pos, center);
-  double scale = get_scene_scale(window_center);
-  vector_t pixel_center_offset = vec_multiply(scale, scene_center_offset);
-  vector_t pixel = {.x = round(window_center.x + pixel_center_offset.x),
-                    // Flip y axis since positive y is down on the screen
-                    .y = round(window_center.y - pixel_center_offset.y)};
+vector_t get_window_position(vector_t scene_pos) {
+  view_t *v = sdl_get_view();
+  vector_t pixel = {.x = round(v->offset.x + v->scale * scene_pos.x),
+                    .y = round(v->offset.y - v->scale * scene_pos.y)};
   return pixel;
 }
 
+/**
+ * Makes sure the scratch buffers hold a polygon of at least n vertices.
+ */
+void sdl_reserve_scratch(size_t n) {
+  if (n <= scratch_capacity) {
+    return;
+  }
+  scratch_points = realloc(scratch_points, sizeof(vector_t) * n);
+  assert(scratch_points != NULL);
+  scratch_fan = realloc(scratch_fan, sizeof(int) * 3 * (n - 2));
+  assert(scratch_fan != NULL);
+  // Fan triangles only depend on their position, so they are written once
+  for (size_t i = scratch_capacity > 2 ? scratch_capacity - 1 : 1; i + 1 < n;
+       i++) {
+    scratch_fan[3 * (i - 1)] = 0;
+    scratch_fan[3 * (i - 1) + 1] = i;
+    scratch_fan[3 * (i - 1) + 2] = i + 1;
+  }
+  scratch_capacity = n;
+}
+
+/**
+ * Maps scene points to the window positions of batch vertices and gives
+ * them all one color.
+ */
+void sdl_project_vertices(const vector_t *points, size_t n, SDL_Color color,
+                          SDL_Vertex *vertices) {
+  view_t *v = sdl_get_view();
+  for (size_t i = 0; i < n; i++) {
+    vertices[i] = (SDL_Vertex){
+        .position = {v->offset.x + v->scale * points[i].x,
+                     v->offset.y - v->scale * points[i].y},
+        .color = color};
+  }
+}
+
 /**
  * Converts an SDL key code to a char.
  * 7-bit ASCII characters are just returned
@@ -112,28 +256,70 @@ char get_keycode(SDL_Keycode key) {
 }
 
 void sdl_init(vector_t min, vector_t max) {
+  sdl_init_backend(min, max, RENDER_BACKEND_WINDOW);
+}
+
+void sdl_init_backend(vector_t min, vector_t max, render_backend_t chosen) {
   // Check parameters
   assert(min.x < max.x);
   assert(min.y < max.y);
 
   center = vec_multiply(0.5, vec_add(min, max));
   max_diff = vec_subtract(max, center);
-  SDL_Init(SDL_INIT_EVERYTHING);
+  view_valid = false;
+  backend = chosen;
+  if (backend == RENDER_BACKEND_WINDOW) {
+    SDL_Init(SDL_INIT_EVERYTHING);
+    TTF_Init();
+    window = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED,
+                              SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH,
+                              WINDOW_HEIGHT, SDL_WINDOW_RESIZABLE);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+    return;
+  }
+  // No video subsystem, so no display is needed
+  SDL_Init(SDL_INIT_EVENTS | SDL_INIT_TIMER);
   TTF_Init();
-  window = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED,
-                            SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT,
-                            SDL_WINDOW_RESIZABLE);
-  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+  window = NULL;
+  // The null backend never draws, so it only needs a renderer to create
+  // textures with
+  bool drawn = backend == RENDER_BACKEND_SOFTWARE;
+  SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(
+      0, drawn ? WINDOW_WIDTH : 1, drawn ? WINDOW_HEIGHT : 1, 32,
+      SDL_PIXELFORMAT_RGBA32);
+  assert(surface != NULL);
+  renderer = SDL_CreateSoftwareRenderer(surface);
+  assert(renderer != NULL);
+  if (drawn) {
+    frame_surface = surface;
+  }
+}
+
+SDL_Surface *sdl_get_frame_surface(void) { return frame_surface; }
+
+render_stats_t sdl_get_render_stats(void) { return render_stats; }
+
+void sdl_reset_render_stats(void) {
+  render_stats = (render_stats_t){0};
 }
 
 bool sdl_is_done(void *game) {
-  SDL_Event *event = malloc(sizeof(*event));
-  assert(event != NULL);
+  SDL_Event event_storage;
+  SDL_Event *event = &event_storage;
   while (SDL_PollEvent(event)) {
     switch (event->type) {
     case SDL_QUIT:
-      free(event);
       return true;
+    case SDL_WINDOWEVENT:
+      if (event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+        sdl_invalidate_view();
+      }
+      break;
+    case SDL_RENDER_TARGETS_RESET:
+    case SDL_RENDER_DEVICE_RESET:
+      // The static layer's pixels were lost
+      sdl_invalidate_static_layer();
+      break;
     case SDL_KEYDOWN:
     case SDL_KEYUP:
       // Skip the keypress if no handler is configured
@@ -155,7 +341,6 @@ bool sdl_is_done(void *game) {
       break;
     }
   }
-  free(event);
   return false;
 }
 
@@ -172,25 +357,50 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color) {
   assert(0 <= color.g && color.g <= 1);
   assert(0 <= color.b && color.b <= 1);
 
-  vector_t window_center = get_window_center();
+  if (polygon_batch == NULL) {
+    polygon_batch = triangle_batch_init();
+  }
+  sdl_reserve_scratch(n);
+  for (size_t i = 0; i < n; i++) {
+    scratch_points[i] = *(vector_t *)list_get(points, i);
+  }
+  SDL_Color vertex_color = {color.r * 255, color.g * 255, color.b * 255, 255};
+  sdl_project_vertices(
+      scratch_points, n, vertex_color,
+      triangle_batch_add(polygon_batch, n, scratch_fan, 3 * (n - 2)));
+  sdl_flush_polygons();
+}
 
-  // Convert each vertex to a point on screen
-  int16_t *x_points = malloc(sizeof(*x_points) * n),
-          *y_points = malloc(sizeof(*y_points) * n);
-  assert(x_points != NULL);
-  assert(y_points != NULL);
+void sdl_queue_body(body_t *body) {
+  if (polygon_batch == NULL) {
+    polygon_batch = triangle_batch_init();
+  }
+  size_t n = body_get_vertex_count(body), index_count;
+  const int *triangles =
+      prototype_get_triangles(body_get_prototype(body), &index_count);
+  if (index_count == 0) {
+    return;
+  }
+  sdl_reserve_scratch(n);
   for (size_t i = 0; i < n; i++) {
-    vector_t *vertex = list_get(points, i);
-    vector_t pixel = get_window_position(*vertex, window_center);
-    x_points[i] = pixel.x;
-    y_points[i] = pixel.y;
+    scratch_points[i] = body_get_vertex(body, i);
   }
+  rgb_color_t color = body_get_color(body);
+  SDL_Color vertex_color = {color.r * 255, color.g * 255, color.b * 255, 255};
+  sdl_project_vertices(
+      scratch_points, n, vertex_color,
+      triangle_batch_add(polygon_batch, n, triangles, index_count));
+}
+
+void sdl_flush_polygons(void) {
+  if (polygon_batch != NULL) {
+    triangle_batch_flush(polygon_batch, renderer, NULL);
+  }
+}
 
-  // Draw polygon with the given color
-  filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
-                    color.g * 255, color.b * 255, 255);
-  free(x_points);
-  free(y_points);
+void sdl_draw_body(body_t *body) {
+  sdl_queue_body(body);
+  sdl_flush_polygons();
 }
 
 SDL_Rect sdl_sprite_rect(vector_t pos, vector_t dims, double scaling) {
@@ -205,81 +415,336 @@ SDL_Rect sdl_sprite_rect(vector_t pos, vector_t dims, double scaling) {
 }
 
 void sdl_draw_sprite(sprite_t *sprite, vector_t pos) {
-  int w, h;
-  SDL_Texture *texture = sprite_get_texture(sprite);
-  SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+  SDL_Rect region = sprite_get_region(sprite);
   double scaling = sprite_get_scaling(sprite);
-  SDL_Rect sprite_rect = sdl_sprite_rect(pos, (vector_t){w, h}, scaling);
-  SDL_RenderCopy(renderer, texture, NULL, &sprite_rect);
+  SDL_Rect sprite_rect =
+      sdl_sprite_rect(pos, (vector_t){region.w, region.h}, scaling);
+  SDL_RenderCopy(renderer, sprite_get_texture(sprite), &region, &sprite_rect);
 }
 
-void sdl_draw_background(sprite_t *sprite) {
+void sdl_flush_sprites(void) {
+  if (sprite_batch != NULL) {
+    quad_batch_flush(sprite_batch, renderer, sprite_batch_texture);
+  }
+  sprite_batch_texture = NULL;
+}
+
+void sdl_queue_sprite(sprite_t *sprite, vector_t pos) {
+  if (sprite_batch == NULL) {
+    sprite_batch = quad_batch_init();
+  }
   SDL_Texture *texture = sprite_get_texture(sprite);
-  SDL_RenderCopy(renderer, texture, NULL, NULL);
+  if (texture != sprite_batch_texture) {
+    sdl_flush_sprites();
+    sprite_batch_texture = texture;
+    SDL_QueryTexture(texture, NULL, NULL, &sprite_batch_width,
+                     &sprite_batch_height);
+  }
+  SDL_Rect region = sprite_get_region(sprite);
+  SDL_Rect sprite_rect = sdl_sprite_rect(
+      pos, (vector_t){region.w, region.h}, sprite_get_scaling(sprite));
+  quad_batch_add(sprite_batch, sprite_rect, region, sprite_batch_width,
+                 sprite_batch_height, SPRITE_TINT);
 }
 
-void sdl_show(void) {
-  // Draw boundary lines
-  vector_t window_center = get_window_center();
+void sdl_draw_background(sprite_t *sprite) {
+  SDL_Rect region = sprite_get_region(sprite);
+  SDL_RenderCopy(renderer, sprite_get_texture(sprite), &region, NULL);
+}
+
+void sdl_draw_boundary(void) {
   vector_t max = vec_add(center, max_diff),
            min = vec_subtract(center, max_diff);
-  vector_t max_pixel = get_window_position(max, window_center),
-           min_pixel = get_window_position(min, window_center);
-  SDL_Rect *boundary = malloc(sizeof(*boundary));
-  boundary->x = min_pixel.x;
-  boundary->y = max_pixel.y;
-  boundary->w = max_pixel.x - min_pixel.x;
-  boundary->h = min_pixel.y - max_pixel.y;
+  vector_t max_pixel = get_window_position(max),
+           min_pixel = get_window_position(min);
+  SDL_Rect boundary = {.x = min_pixel.x,
+                       .y = max_pixel.y,
+                       .w = max_pixel.x - min_pixel.x,
+                       .h = min_pixel.y - max_pixel.y};
   SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-  SDL_RenderDrawRect(renderer, boundary);
-  free(boundary);
+  SDL_RenderDrawRect(renderer, &boundary);
+}
 
+void sdl_show(void) {
+  sdl_draw_boundary();
   SDL_RenderPresent(renderer);
 }
 
+font_entry_t *sdl_get_font_entry(int size) {
+  if (fonts == NULL) {
+    fonts = list_init(INIT_FONTS_SIZE, free);
+  }
+  for (size_t i = 0; i < list_size(fonts); i++) {
+    font_entry_t *entry = list_get(fonts, i);
+    if (entry->size == size) {
+      return entry;
+    }
+  }
+  font_entry_t *entry = malloc(sizeof(font_entry_t));
+  assert(entry != NULL);
+  entry->size = size;
+  entry->font = TTF_OpenFont(FONT_FILE, size);
+  assert(entry->font != NULL);
+  entry->atlas = NULL;
+  list_add(fonts, entry);
+  return entry;
+}
+
+TTF_Font *sdl_get_font(int size) { return sdl_get_font_entry(size)->font; }
+
+glyph_atlas_t *sdl_get_glyph_atlas(int size) {
+  font_entry_t *entry = sdl_get_font_entry(size);
+  if (entry->atlas == NULL) {
+    entry->atlas = glyph_atlas_init(renderer, entry->font);
+  }
+  return entry->atlas;
+}
+
+void sdl_queue_text(text_t *text) {
+  vector_t sdl_pos =
+      get_window_position(text_get_pos(text));
+  glyph_atlas_queue(sdl_get_glyph_atlas(text_get_size(text)),
+                    text_get_content(text), sdl_pos, text_get_color(text));
+}
+
+void sdl_flush_text(void) {
+  if (fonts == NULL) {
+    return;
+  }
+  for (size_t i = 0; i < list_size(fonts); i++) {
+    font_entry_t *entry = list_get(fonts, i);
+    if (entry->atlas != NULL) {
+      glyph_atlas_flush(entry->atlas, renderer);
+    }
+  }
+}
+
 void sdl_draw_text(text_t *text) {
-  SDL_Rect *text_area = malloc(sizeof(SDL_Rect));
-  SDL_Color fg = text_get_color(text);
-  TTF_Font *t_font = TTF_OpenFont(FONT_FILE, text_get_size(text)); // test font
-  SDL_Surface *t_surf =
-      TTF_RenderText_Blended(t_font, text_get_content(text), fg);
-  SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, t_surf);
+  if (text_get_texture(text) == NULL) {
+    TTF_Font *t_font = sdl_get_font(text_get_size(text));
+    SDL_Surface *t_surf = TTF_RenderText_Blended(
+        t_font, text_get_content(text), text_get_color(text));
+    if (t_surf == NULL) {
+      return; // nothing to draw, e.g. an empty string
+    }
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, t_surf);
+    text_set_texture(text, texture, t_surf->w, t_surf->h);
+    SDL_FreeSurface(t_surf);
+  }
   vector_t sdl_pos =
-      get_window_position(text_get_pos(text), get_window_center());
+      get_window_position(text_get_pos(text));
+  SDL_Rect text_area = {.x = sdl_pos.x,
+                        .y = sdl_pos.y,
+                        .w = text_get_width(text),
+                        .h = text_get_height(text)};
+  SDL_RenderCopy(renderer, text_get_texture(text), NULL, &text_area);
+}
 
-  text_area->x = sdl_pos.x;
-  text_area->y = sdl_pos.y;
-  text_area->w = t_surf->w;
-  text_area->h = t_surf->h;
+void sdl_record_scene(render_queue_t *queue, scene_t *scene,
+                      bool include_static) {
+  if (!include_static) {
+    render_command_t command = {.kind = RENDER_STATIC_LAYER,
+                                .texture = static_layer};
+    render_queue_push(queue, RENDER_LAYER_BACKGROUND, SDL_BLENDMODE_NONE,
+                      command);
+  } else if (scene_has_sprite(scene)) {
+    sprite_t *background = scene_get_sprite(scene);
+    render_command_t command = {.kind = RENDER_BACKGROUND,
+                                .texture = sprite_get_texture(background),
+                                .item = background};
+    render_queue_push(queue, RENDER_LAYER_BACKGROUND, SDL_BLENDMODE_NONE,
+                      command);
+  }
+  for (size_t i = 0; i < scene_get_texts_count(scene); i++) {
+    text_t *text = scene_get_text(scene, i);
+    render_command_t command = {
+        .kind = text_is_dynamic(text) ? RENDER_GLYPHS : RENDER_TEXT,
+        .texture = NULL,
+        .item = text};
+    render_queue_push(queue, RENDER_LAYER_TEXT, SDL_BLENDMODE_BLEND,
+                      command);
+  }
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (!include_static && body_is_static(body)) {
+      continue;
+    }
+    if (body_has_sprite(body)) {
+      sprite_t *sprite = body_get_sprite(body);
+      render_command_t command = {
+          .kind = RENDER_SPRITE,
+          .texture = sprite_get_texture(sprite),
+          .item = sprite,
+          .pos = get_window_position(body_get_centroid(body))};
+      render_queue_push(queue, RENDER_LAYER_BODIES, SDL_BLENDMODE_BLEND,
+                        command);
+    } else {
+      render_command_t command = {.kind = RENDER_POLYGON, .item = body};
+      render_queue_push(queue, RENDER_LAYER_BODIES, SDL_BLENDMODE_NONE,
+                        command);
+    }
+  }
+}
 
-  SDL_RenderCopy(renderer, texture, NULL, text_area);
-  SDL_FreeSurface(t_surf);
-  TTF_CloseFont(t_font);
+void sdl_submit(render_queue_t *queue) {
+  for (size_t i = 0; i < render_queue_size(queue); i++) {
+    render_command_t *command = render_queue_get(queue, i);
+    // Batches are drawn as soon as a command of another kind comes up
+    if (command->kind != RENDER_SPRITE) {
+      sdl_flush_sprites();
+    }
+    if (command->kind != RENDER_GLYPHS) {
+      sdl_flush_text();
+    }
+    if (command->kind != RENDER_POLYGON) {
+      sdl_flush_polygons();
+    }
+    switch (command->kind) {
+    case RENDER_STATIC_LAYER:
+      SDL_RenderCopy(renderer, command->texture, NULL, NULL);
+      break;
+    case RENDER_BACKGROUND:
+      sdl_draw_background(command->item);
+      break;
+    case RENDER_SPRITE:
+      sdl_queue_sprite(command->item, command->pos);
+      break;
+    case RENDER_POLYGON:
+      sdl_queue_body(command->item);
+      break;
+    case RENDER_TEXT:
+      sdl_draw_text(command->item);
+      break;
+    case RENDER_GLYPHS:
+      sdl_queue_text(command->item);
+      break;
+    }
+  }
+  sdl_flush_sprites();
+  sdl_flush_text();
+  sdl_flush_polygons();
 }
 
-void sdl_render_scene(scene_t *scene) {
+/**
+ * Adds the bytes of a value to an FNV-1a hash.
+ */
+uint64_t sdl_hash(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+/**
+ * Fingerprints everything the static layer of a scene shows.
+ */
+uint64_t sdl_static_signature(scene_t *scene, int width, int height) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  hash = sdl_hash(hash, &scene, sizeof(scene));
+  hash = sdl_hash(hash, &width, sizeof(width));
+  hash = sdl_hash(hash, &height, sizeof(height));
+  if (scene_has_sprite(scene)) {
+    SDL_Texture *texture = sprite_get_texture(scene_get_sprite(scene));
+    SDL_Rect region = sprite_get_region(scene_get_sprite(scene));
+    hash = sdl_hash(hash, &texture, sizeof(texture));
+    hash = sdl_hash(hash, &region, sizeof(region));
+  }
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (body_is_static(body)) {
+      size_t version = body_get_version(body);
+      hash = sdl_hash(hash, &body, sizeof(body));
+      hash = sdl_hash(hash, &version, sizeof(version));
+    }
+  }
+  return hash;
+}
+
+void sdl_invalidate_static_layer(void) {
+  if (static_layer != NULL) {
+    SDL_DestroyTexture(static_layer);
+    static_layer = NULL;
+  }
+}
+
+/**
+ * Redraws the static layer if what it shows has changed.
+ * Returns whether the static layer can be used this frame.
+ */
+bool sdl_update_static_layer(scene_t *scene) {
+  if (!SDL_RenderTargetSupported(renderer)) {
+    return false;
+  }
+  int width = sdl_get_view()->width, height = sdl_get_view()->height;
+  uint64_t signature = sdl_static_signature(scene, width, height);
+  if (static_layer != NULL && signature == static_layer_signature) {
+    return true;
+  }
+  if (static_layer != NULL &&
+      (width != static_layer_width || height != static_layer_height)) {
+    sdl_invalidate_static_layer();
+  }
+  if (static_layer == NULL) {
+    static_layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                     SDL_TEXTUREACCESS_TARGET, width, height);
+    if (static_layer == NULL) {
+      return false;
+    }
+    static_layer_width = width;
+    static_layer_height = height;
+  }
+  SDL_SetRenderTarget(renderer, static_layer);
+  render_stats.static_layer_draws++;
   sdl_clear();
-  size_t body_count = scene_bodies(scene);
   if (scene_has_sprite(scene)) {
     sdl_draw_background(scene_get_sprite(scene));
   }
-  for (size_t i = 0; i < scene_get_texts_count(scene); i++) {
-    text_t *text = scene_get_text(scene, i);
-    sdl_draw_text(text);
-  }
-  for (size_t i = 0; i < body_count; i++) {
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
     body_t *body = scene_get_body(scene, i);
+    if (!body_is_static(body)) {
+      continue;
+    }
     if (body_has_sprite(body)) {
-      vector_t window_pos =
-          get_window_position(body_get_centroid(body), get_window_center());
-      sdl_draw_sprite(body_get_sprite(body), window_pos);
+      sdl_draw_sprite(body_get_sprite(body),
+                      get_window_position(body_get_centroid(body)));
     } else {
-      list_t *shape = body_get_shape(body);
-      sdl_draw_polygon(shape, body_get_color(body));
-      list_free(shape);
+      sdl_draw_body(body);
     }
   }
-  sdl_show();
+  sdl_draw_boundary();
+  SDL_SetRenderTarget(renderer, NULL);
+  static_layer_signature = signature;
+  return true;
+}
+
+void sdl_render_scene(scene_t *scene) {
+  clock_t start = clock();
+  if (frame_queue == NULL) {
+    frame_queue = render_queue_init();
+  }
+  bool cached =
+      backend != RENDER_BACKEND_NULL && sdl_update_static_layer(scene);
+  render_queue_clear(frame_queue);
+  sdl_record_scene(frame_queue, scene, !cached);
+  render_queue_sort(frame_queue);
+  render_stats.frames++;
+  render_stats.commands += render_queue_size(frame_queue);
+  render_stats.textures += render_queue_textures(frame_queue);
+  if (backend == RENDER_BACKEND_NULL) {
+    render_stats.seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+    return;
+  }
+  if (!cached) {
+    sdl_clear();
+  }
+  sdl_submit(frame_queue);
+  if (cached) {
+    SDL_RenderPresent(renderer);
+  } else {
+    sdl_show();
+  }
+  render_stats.seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
 }
 
 void sdl_render_game(game_t *game) {
@@ -301,4 +766,36 @@ SDL_Texture *sdl_create_texture(const char *f) {
   SDL_Texture *t = IMG_LoadTexture(renderer, f);
   assert(t);
   return t;
+}
+
+SDL_Surface *sdl_load_rgba_surface(const char *f) {
+  SDL_Surface *loaded = IMG_Load(f);
+  assert(loaded);
+  SDL_Surface *surface =
+      SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+  SDL_FreeSurface(loaded);
+  assert(surface);
+  return surface;
+}
+
+SDL_Texture *sdl_create_texture_with_mask(const char *f, mask_t **mask) {
+  SDL_Surface *surface = sdl_load_rgba_surface(f);
+  *mask = mask_from_surface(surface, MASK_ALPHA_THRESHOLD);
+  SDL_Texture *t = SDL_CreateTextureFromSurface(renderer, surface);
+  SDL_FreeSurface(surface);
+  assert(t);
+  return t;
+}
+
+mask_t *sdl_create_mask(const char *f) {
+  SDL_Surface *surface = sdl_load_rgba_surface(f);
+  mask_t *mask = mask_from_surface(surface, MASK_ALPHA_THRESHOLD);
+  SDL_FreeSurface(surface);
+  return mask;
+}
+
+SDL_Texture *sdl_create_texture_from_surface(SDL_Surface *surface) {
+  SDL_Texture *t = SDL_CreateTextureFromSurface(renderer, surface);
+  assert(t);
+  return t;
 }
\ No newline at end of file
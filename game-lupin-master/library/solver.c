@@ -0,0 +1,175 @@
+#include "solver.h"
+#include "body.h"
+#include "collision.h"
+#include "list.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const size_t INIT_CONTACTS_SIZE = 16;
+// Velocity passes per tick; contacts converge within a handful at 60 ticks/s
+static const size_t SOLVER_ITERATIONS = 8;
+// Approach speeds below this don't bounce, so resting contacts stay at rest
+static const double RESTITUTION_THRESHOLD = 1;
+// Overlap tolerated without positional correction, to avoid jitter
+static const double PENETRATION_SLOP = 0.5;
+// Fraction of the remaining overlap removed each tick
+static const double CORRECTION_PERCENT = 0.8;
+
+typedef struct contact {
+  body_t *body1;
+  body_t *body2;
+  double elasticity;
+  collision_info_t info;
+  collision_cache_t cache;
+  double impulse;
+  // per-tick values computed when the solve starts
+  double inv_mass1;
+  double inv_mass2;
+  double bounce;
+} contact_t;
+
+typedef struct solver {
+  list_t *contacts;
+} solver_t;
+
+contact_t *contact_init(body_t *body1, body_t *body2, double elasticity) {
+  contact_t *contact = malloc(sizeof(contact_t));
+  assert(contact != NULL);
+  contact->body1 = body1;
+  contact->body2 = body2;
+  contact->elasticity = elasticity;
+  contact->info.collided = false;
+  contact->cache = collision_cache_init();
+  contact->impulse = 0;
+  return contact;
+}
+
+void contact_free(contact_t *contact) { free(contact); }
+
+bool contact_update(contact_t *contact) {
+  contact->info =
+      body_find_collision(contact->body1, contact->body2, &contact->cache);
+  if (!contact->info.collided) {
+    contact->impulse = 0;
+  }
+  return contact->info.collided;
+}
+
+body_t *contact_get_body1(contact_t *contact) { return contact->body1; }
+
+body_t *contact_get_body2(contact_t *contact) { return contact->body2; }
+
+bool contact_is_touching(contact_t *contact) {
+  return contact->info.collided;
+}
+
+collision_info_t contact_get_info(contact_t *contact) { return contact->info; }
+
+double contact_get_impulse(contact_t *contact) { return contact->impulse; }
+
+solver_t *solver_init(void) {
+  solver_t *solver = malloc(sizeof(solver_t));
+  assert(solver != NULL);
+  solver->contacts = list_init(INIT_CONTACTS_SIZE, NULL);
+  return solver;
+}
+
+void solver_free(solver_t *solver) {
+  list_free(solver->contacts);
+  free(solver);
+}
+
+void solver_clear(solver_t *solver) {
+  while (list_size(solver->contacts) > 0) {
+    list_remove_last(solver->contacts);
+  }
+}
+
+void solver_add_contact(solver_t *solver, contact_t *contact) {
+  list_add(solver->contacts, contact);
+}
+
+size_t solver_contacts(solver_t *solver) {
+  return list_size(solver->contacts);
+}
+
+contact_t *solver_get_contact(solver_t *solver, size_t index) {
+  return list_get(solver->contacts, index);
+}
+
+/**
+ * Computes the velocity a body will have after this tick
+ * if no further impulses are applied.
+ */
+vector_t solver_velocity(body_t *body, double inv_mass, double dt) {
+  vector_t change = vec_add(body_get_impulse(body),
+                            vec_multiply(dt, body_get_force(body)));
+  return vec_add(body_get_velocity(body), vec_multiply(inv_mass, change));
+}
+
+/** Computes the speed at which body2 moves away from body1 along the axis */
+double solver_normal_velocity(contact_t *contact, double dt) {
+  vector_t v1 = solver_velocity(contact->body1, contact->inv_mass1, dt);
+  vector_t v2 = solver_velocity(contact->body2, contact->inv_mass2, dt);
+  return vec_dot(vec_subtract(v2, v1), contact->info.axis);
+}
+
+/** Pushes the bodies apart along the axis with the given impulse magnitude */
+void solver_apply_impulse(contact_t *contact, double impulse) {
+  vector_t j = vec_multiply(impulse, contact->info.axis);
+  if (contact->inv_mass1 > 0) {
+    body_add_impulse(contact->body1, vec_negate(j));
+  }
+  if (contact->inv_mass2 > 0) {
+    body_add_impulse(contact->body2, j);
+  }
+}
+
+void solver_solve(solver_t *solver, double dt) {
+  size_t count = list_size(solver->contacts);
+
+  for (size_t i = 0; i < count; i++) {
+    contact_t *contact = list_get(solver->contacts, i);
+    contact->inv_mass1 = body_get_inverse_mass(contact->body1);
+    contact->inv_mass2 = body_get_inverse_mass(contact->body2);
+    double approach = solver_normal_velocity(contact, dt);
+    contact->bounce = approach < -RESTITUTION_THRESHOLD
+                          ? -contact->elasticity * approach
+                          : 0;
+    solver_apply_impulse(contact, contact->impulse);
+  }
+
+  for (size_t iter = 0; iter < SOLVER_ITERATIONS; iter++) {
+    for (size_t i = 0; i < count; i++) {
+      contact_t *contact = list_get(solver->contacts, i);
+      double inv_mass_sum = contact->inv_mass1 + contact->inv_mass2;
+      if (inv_mass_sum == 0) {
+        continue;
+      }
+      double normal_vel = solver_normal_velocity(contact, dt);
+      double lambda = (contact->bounce - normal_vel) / inv_mass_sum;
+      // the total impulse may only ever push the bodies apart
+      double total = fmax(contact->impulse + lambda, 0);
+      solver_apply_impulse(contact, total - contact->impulse);
+      contact->impulse = total;
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    contact_t *contact = list_get(solver->contacts, i);
+    double inv_mass_sum = contact->inv_mass1 + contact->inv_mass2;
+    double overlap = contact->info.depth - PENETRATION_SLOP;
+    if (inv_mass_sum == 0 || overlap <= 0) {
+      continue;
+    }
+    vector_t correction = vec_multiply(
+        CORRECTION_PERCENT * overlap / inv_mass_sum, contact->info.axis);
+    body_move_centroid(contact->body1,
+                       vec_multiply(-contact->inv_mass1, correction));
+    body_move_centroid(contact->body2,
+                       vec_multiply(contact->inv_mass2, correction));
+  }
+}
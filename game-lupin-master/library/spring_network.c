@@ -0,0 +1,388 @@
+#include "spring_network.h"
+#include "body.h"
+#include "forces.h"
+#include "list.h"
+#include "scene.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const size_t INIT_NODES_SIZE = 8;
+static const size_t INIT_SPRINGS_CAPACITY = 8;
+// Warm-started from last tick, a few iterations track the solution closely
+static const size_t CG_ITERATIONS = 10;
+// Stop early once the residual has shrunk by this factor (squared)
+static const double CG_TOLERANCE = 1e-10;
+
+typedef struct spring {
+  size_t node1;
+  size_t node2;
+  double k;
+  double rest_length;
+  // where the spring's off-diagonal blocks live in the CSR arrays
+  size_t entry12;
+  size_t entry21;
+} spring_t;
+
+/** A symmetric 2x2 matrix {{xx, xy}, {xy, yy}} */
+typedef struct block {
+  double xx;
+  double xy;
+  double yy;
+} block_t;
+
+typedef struct spring_network {
+  scene_t *scene;
+  // owned by the force creator, which frees it after the network
+  list_t *nodes;
+  spring_t *springs;
+  size_t spring_count;
+  size_t spring_capacity;
+
+  // the stiffness matrix K in block CSR form: one 2x2 block per spring end;
+  // the sparsity pattern is rebuilt when springs are added, the values
+  // every tick. Diagonal blocks are stored separately.
+  bool dirty;
+  size_t *row_start;
+  size_t *columns;
+  block_t *values;
+  block_t *diagonal;
+
+  // per node scratch space, with two entries (x, y) per node
+  size_t capacity;
+  double *masses;
+  // the velocity change, kept to warm-start the next tick
+  vector_t *solution;
+  vector_t *rhs;
+  vector_t *residual;
+  vector_t *direction;
+  vector_t *product;
+} spring_network_t;
+
+void spring_network_free(spring_network_t *network) {
+  free(network->springs);
+  free(network->row_start);
+  free(network->columns);
+  free(network->values);
+  free(network->diagonal);
+  free(network->masses);
+  free(network->solution);
+  free(network->rhs);
+  free(network->residual);
+  free(network->direction);
+  free(network->product);
+  free(network);
+}
+
+size_t spring_network_node(spring_network_t *network, body_t *body) {
+  for (size_t i = 0; i < list_size(network->nodes); i++) {
+    if (list_get(network->nodes, i) == body) {
+      return i;
+    }
+  }
+  list_add(network->nodes, body);
+  return list_size(network->nodes) - 1;
+}
+
+void spring_network_add_spring(spring_network_t *network, double k,
+                               double rest_length, body_t *body1,
+                               body_t *body2) {
+  if (network->spring_count == network->spring_capacity) {
+    network->spring_capacity *= 2;
+    network->springs = realloc(network->springs,
+                               sizeof(spring_t) * network->spring_capacity);
+    assert(network->springs != NULL);
+  }
+  spring_t *spring = &network->springs[network->spring_count];
+  spring->node1 = spring_network_node(network, body1);
+  spring->node2 = spring_network_node(network, body2);
+  spring->k = k;
+  spring->rest_length = rest_length;
+  network->spring_count++;
+  network->dirty = true;
+}
+
+size_t spring_network_springs(spring_network_t *network) {
+  return network->spring_count;
+}
+
+size_t spring_network_bodies(spring_network_t *network) {
+  return list_size(network->nodes);
+}
+
+void *spring_network_realloc(void *array, size_t size) {
+  array = realloc(array, size);
+  assert(array != NULL);
+  return array;
+}
+
+/** Grows the per-node arrays, starting new nodes from a zero guess */
+void spring_network_reserve(spring_network_t *network, size_t size) {
+  if (size <= network->capacity) {
+    return;
+  }
+  size_t vectors = sizeof(vector_t) * size;
+  network->masses =
+      spring_network_realloc(network->masses, sizeof(double) * size);
+  network->diagonal =
+      spring_network_realloc(network->diagonal, sizeof(block_t) * size);
+  network->row_start =
+      spring_network_realloc(network->row_start, sizeof(size_t) * (size + 1));
+  network->solution = spring_network_realloc(network->solution, vectors);
+  network->rhs = spring_network_realloc(network->rhs, vectors);
+  network->residual = spring_network_realloc(network->residual, vectors);
+  network->direction = spring_network_realloc(network->direction, vectors);
+  network->product = spring_network_realloc(network->product, vectors);
+  for (size_t i = network->capacity; i < size; i++) {
+    network->solution[i] = VEC_ZERO;
+  }
+  network->capacity = size;
+}
+
+/** Builds the CSR sparsity pattern: one entry per spring end */
+void spring_network_assemble(spring_network_t *network) {
+  size_t size = list_size(network->nodes);
+  spring_network_reserve(network, size);
+  size_t entries = 2 * network->spring_count;
+  network->columns =
+      spring_network_realloc(network->columns, sizeof(size_t) * entries);
+  network->values =
+      spring_network_realloc(network->values, sizeof(block_t) * entries);
+
+  // count the entries of each row, then turn the counts into offsets
+  for (size_t i = 0; i <= size; i++) {
+    network->row_start[i] = 0;
+  }
+  for (size_t s = 0; s < network->spring_count; s++) {
+    network->row_start[network->springs[s].node1 + 1]++;
+    network->row_start[network->springs[s].node2 + 1]++;
+  }
+  for (size_t i = 0; i < size; i++) {
+    network->row_start[i + 1] += network->row_start[i];
+  }
+  size_t *fill = malloc(sizeof(size_t) * size);
+  assert(fill != NULL);
+  for (size_t i = 0; i < size; i++) {
+    fill[i] = network->row_start[i];
+  }
+  for (size_t s = 0; s < network->spring_count; s++) {
+    spring_t *spring = &network->springs[s];
+    spring->entry12 = fill[spring->node1]++;
+    network->columns[spring->entry12] = spring->node2;
+    spring->entry21 = fill[spring->node2]++;
+    network->columns[spring->entry21] = spring->node1;
+  }
+  free(fill);
+  network->dirty = false;
+}
+
+vector_t block_multiply(block_t block, vector_t v) {
+  return (vector_t){block.xx * v.x + block.xy * v.y,
+                    block.xy * v.x + block.yy * v.y};
+}
+
+void block_add(block_t *block, block_t other, double scale) {
+  block->xx += scale * other.xx;
+  block->xy += scale * other.xy;
+  block->yy += scale * other.yy;
+}
+
+/**
+ * Fills in the stiffness blocks and spring forces for the current positions.
+ * A spring along unit direction n with length l and rest length L has
+ * stiffness k (n n^T + max(1 - L / l, 0) (I - n n^T)); the clamp drops the
+ * transverse term of compressed springs, which would make K indefinite.
+ * The forces are added to rhs.
+ */
+void spring_network_linearize(spring_network_t *network) {
+  size_t size = list_size(network->nodes);
+  for (size_t i = 0; i < size; i++) {
+    network->diagonal[i] = (block_t){0, 0, 0};
+    network->rhs[i] = VEC_ZERO;
+  }
+  for (size_t s = 0; s < network->spring_count; s++) {
+    spring_t *spring = &network->springs[s];
+    vector_t disp = vec_subtract(
+        body_get_centroid(list_get(network->nodes, spring->node2)),
+        body_get_centroid(list_get(network->nodes, spring->node1)));
+    double length = vec_magnitude(disp);
+    block_t stiffness;
+    vector_t force;
+    if (length == 0) {
+      // no direction to push along; act as a zero-length spring
+      stiffness = (block_t){spring->k, 0, spring->k};
+      force = VEC_ZERO;
+    } else {
+      vector_t n = vec_multiply(1 / length, disp);
+      double transverse = fmax(1 - spring->rest_length / length, 0);
+      stiffness = (block_t){
+          spring->k * (n.x * n.x + transverse * (1 - n.x * n.x)),
+          spring->k * (n.x * n.y - transverse * n.x * n.y),
+          spring->k * (n.y * n.y + transverse * (1 - n.y * n.y))};
+      force = vec_multiply(spring->k * (length - spring->rest_length), n);
+    }
+    block_add(&network->diagonal[spring->node1], stiffness, 1);
+    block_add(&network->diagonal[spring->node2], stiffness, 1);
+    network->values[spring->entry12] = (block_t){0, 0, 0};
+    block_add(&network->values[spring->entry12], stiffness, -1);
+    network->values[spring->entry21] = network->values[spring->entry12];
+    network->rhs[spring->node1] = vec_add(network->rhs[spring->node1], force);
+    network->rhs[spring->node2] =
+        vec_subtract(network->rhs[spring->node2], force);
+  }
+}
+
+/** Computes out = K * in */
+void spring_network_stiffness(spring_network_t *network, vector_t *in,
+                              vector_t *out) {
+  size_t size = list_size(network->nodes);
+  for (size_t i = 0; i < size; i++) {
+    vector_t sum = block_multiply(network->diagonal[i], in[i]);
+    for (size_t e = network->row_start[i]; e < network->row_start[i + 1];
+         e++) {
+      sum = vec_add(sum,
+                    block_multiply(network->values[e], in[network->columns[e]]));
+    }
+    out[i] = sum;
+  }
+}
+
+/**
+ * Computes out = (M + dt^2 K) * in over the free nodes.
+ * Anchors (infinite mass) keep a zero velocity change, so their rows and
+ * columns drop out of the system.
+ */
+void spring_network_system(spring_network_t *network, double dt, vector_t *in,
+                           vector_t *out) {
+  size_t size = list_size(network->nodes);
+  spring_network_stiffness(network, in, out);
+  for (size_t i = 0; i < size; i++) {
+    if (isinf(network->masses[i])) {
+      out[i] = VEC_ZERO;
+    } else {
+      out[i] = vec_add(vec_multiply(network->masses[i], in[i]),
+                       vec_multiply(dt * dt, out[i]));
+    }
+  }
+}
+
+double spring_network_dot(vector_t *a, vector_t *b, size_t size) {
+  double sum = 0;
+  for (size_t i = 0; i < size; i++) {
+    sum += vec_dot(a[i], b[i]);
+  }
+  return sum;
+}
+
+/** Solves the system for the velocity change with conjugate gradients */
+void spring_network_solve(spring_network_t *network, double dt) {
+  size_t size = list_size(network->nodes);
+  vector_t *x = network->solution;
+  vector_t *r = network->residual;
+  vector_t *p = network->direction;
+  vector_t *ap = network->product;
+
+  for (size_t i = 0; i < size; i++) {
+    if (isinf(network->masses[i])) {
+      x[i] = VEC_ZERO;
+      network->rhs[i] = VEC_ZERO;
+    }
+  }
+  spring_network_system(network, dt, x, ap);
+  for (size_t i = 0; i < size; i++) {
+    r[i] = vec_subtract(network->rhs[i], ap[i]);
+    p[i] = r[i];
+  }
+  double rr = spring_network_dot(r, r, size);
+  double threshold =
+      CG_TOLERANCE * spring_network_dot(network->rhs, network->rhs, size);
+  for (size_t iter = 0; iter < CG_ITERATIONS && rr > threshold; iter++) {
+    spring_network_system(network, dt, p, ap);
+    double pap = spring_network_dot(p, ap, size);
+    if (pap <= 0) {
+      break;
+    }
+    double alpha = rr / pap;
+    for (size_t i = 0; i < size; i++) {
+      x[i] = vec_add(x[i], vec_multiply(alpha, p[i]));
+      r[i] = vec_subtract(r[i], vec_multiply(alpha, ap[i]));
+    }
+    double next_rr = spring_network_dot(r, r, size);
+    double beta = next_rr / rr;
+    for (size_t i = 0; i < size; i++) {
+      p[i] = vec_add(r[i], vec_multiply(beta, p[i]));
+    }
+    rr = next_rr;
+  }
+}
+
+void spring_network_force_creator(spring_network_t *network) {
+  size_t size = list_size(network->nodes);
+  double dt = scene_get_dt(network->scene);
+  if (size == 0 || dt <= 0) {
+    return;
+  }
+  if (network->dirty) {
+    spring_network_assemble(network);
+  }
+  bool awake = false;
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(network->nodes, i);
+    network->masses[i] = body_get_mass(body);
+    awake = awake || !body_is_sleeping(body);
+  }
+  if (!awake) {
+    return;
+  }
+
+  // right-hand side dt * (f - dt * K * v)
+  spring_network_linearize(network);
+  vector_t *velocities = network->residual;
+  for (size_t i = 0; i < size; i++) {
+    velocities[i] = body_get_velocity(list_get(network->nodes, i));
+  }
+  spring_network_stiffness(network, velocities, network->product);
+  for (size_t i = 0; i < size; i++) {
+    network->rhs[i] = vec_multiply(
+        dt, vec_subtract(network->rhs[i],
+                         vec_multiply(dt, network->product[i])));
+  }
+
+  spring_network_solve(network, dt);
+  for (size_t i = 0; i < size; i++) {
+    if (isinf(network->masses[i])) {
+      continue;
+    }
+    body_add_impulse(list_get(network->nodes, i),
+                     vec_multiply(network->masses[i], network->solution[i]));
+  }
+}
+
+spring_network_t *create_spring_network(scene_t *scene) {
+  spring_network_t *network = malloc(sizeof(spring_network_t));
+  assert(network != NULL);
+  network->scene = scene;
+  network->nodes = list_init(INIT_NODES_SIZE, NULL);
+  network->spring_capacity = INIT_SPRINGS_CAPACITY;
+  network->springs = malloc(sizeof(spring_t) * network->spring_capacity);
+  assert(network->springs != NULL);
+  network->spring_count = 0;
+  network->dirty = true;
+  network->row_start = NULL;
+  network->columns = NULL;
+  network->values = NULL;
+  network->diagonal = NULL;
+  network->capacity = 0;
+  network->masses = NULL;
+  network->solution = NULL;
+  network->rhs = NULL;
+  network->residual = NULL;
+  network->direction = NULL;
+  network->product = NULL;
+  scene_add_bodies_force_creator(
+      scene, (force_creator_t)spring_network_force_creator, network,
+      network->nodes, (free_func_t)spring_network_free);
+  return network;
+}
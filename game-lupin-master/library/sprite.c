@@ -1,4 +1,6 @@
+#include "mask.h"
 #include "sdl_wrapper.h"
+#include "texture_cache.h"
 #include <SDL2/SDL_image.h>
 #include <assert.h>
 #include <stdbool.h>
@@ -6,44 +8,77 @@
 typedef struct sprite {
   bool has_sprite;
   SDL_Texture *texture;
+  // The part of texture that shows the sprite
+  SDL_Rect region;
   double scaling;
+  mask_t *mask;
 } sprite_t;
 
 sprite_t *sprite_init() {
   sprite_t *sprite = malloc(sizeof(sprite_t));
   sprite->has_sprite = false;
   sprite->texture = NULL;
+  sprite->region = (SDL_Rect){0, 0, 0, 0};
   sprite->scaling = 1;
+  sprite->mask = NULL;
   return sprite;
 }
 
-void sprite_free(sprite_t *sprite) {
-  if (sprite->has_sprite) {
-    assert(sprite->texture);
+/**
+ * Gives back the sprite's reference to its texture. Textures that did not
+ * come from the texture cache belong to the sprite and are destroyed,
+ * unless the sprite is about to keep using them.
+ */
+void sprite_release_texture(sprite_t *sprite, SDL_Texture *next) {
+  if (!sprite->has_sprite) {
+    return;
+  }
+  assert(sprite->texture);
+  if (!texture_cache_release(sprite->texture) && sprite->texture != next) {
     SDL_DestroyTexture(sprite->texture);
   }
+}
+
+void sprite_free(sprite_t *sprite) {
+  sprite_release_texture(sprite, NULL);
   free(sprite);
 }
 
 SDL_Texture *sprite_get_texture(sprite_t *sprite) { return sprite->texture; }
 
 void sprite_set_texture(sprite_t *sprite, SDL_Texture *texture) {
+  sprite_release_texture(sprite, texture);
   sprite->texture = texture;
   sprite->has_sprite = true;
+  sprite->mask = NULL;
+  sprite->region.x = 0;
+  sprite->region.y = 0;
+  SDL_QueryTexture(texture, NULL, NULL, &sprite->region.w,
+                   &sprite->region.h);
 }
 
 void sprite_set_texture_scaled(sprite_t *sprite, SDL_Texture *texture,
                                double scaling) {
-  sprite->texture = texture;
-  sprite->has_sprite = true;
+  sprite_set_texture(sprite, texture);
   sprite->scaling = scaling;
 }
 
 void sprite_load_texture(sprite_t *sprite, char *file) {
-  sprite->texture = sdl_create_texture(file);
-  sprite->has_sprite = true;
+  SDL_Rect region;
+  sprite_set_texture(sprite, texture_cache_acquire(file, &region));
+  sprite_set_region(sprite, region);
+}
+
+SDL_Rect sprite_get_region(sprite_t *sprite) { return sprite->region; }
+
+void sprite_set_region(sprite_t *sprite, SDL_Rect region) {
+  sprite->region = region;
 }
 
+void sprite_set_mask(sprite_t *sprite, mask_t *mask) { sprite->mask = mask; }
+
+mask_t *sprite_get_mask(sprite_t *sprite) { return sprite->mask; }
+
 bool sprite_has_texture(sprite_t *sprite) { return sprite->has_sprite; }
 
 void sprite_set_scaling(sprite_t *sprite, double scaling) {
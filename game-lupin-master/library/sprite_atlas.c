@@ -0,0 +1,140 @@
+#include "sprite_atlas.h"
+#include "list.h"
+#include "sdl_wrapper.h"
+#include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const size_t INIT_PAGES_SIZE = 2;
+// Blank pixels between images, so filtering never bleeds into neighbours
+static const int IMAGE_PADDING = 1;
+
+typedef struct atlas_page {
+  // The page's pixels until it is uploaded, then NULL
+  SDL_Surface *surface;
+  SDL_Texture *texture;
+  // Where the next image goes on the open (bottom) shelf
+  int shelf_x;
+  int shelf_y;
+  int shelf_height;
+} atlas_page_t;
+
+typedef struct sprite_atlas {
+  list_t *pages;
+  int page_size;
+} sprite_atlas_t;
+
+void atlas_page_free(atlas_page_t *page) {
+  if (page->surface != NULL) {
+    SDL_FreeSurface(page->surface);
+  }
+  if (page->texture != NULL) {
+    SDL_DestroyTexture(page->texture);
+  }
+  free(page);
+}
+
+sprite_atlas_t *sprite_atlas_init(int page_size) {
+  sprite_atlas_t *atlas = malloc(sizeof(sprite_atlas_t));
+  assert(atlas != NULL);
+  atlas->pages = list_init(INIT_PAGES_SIZE, (free_func_t)atlas_page_free);
+  atlas->page_size = page_size;
+  return atlas;
+}
+
+void sprite_atlas_free(sprite_atlas_t *atlas) {
+  list_free(atlas->pages);
+  free(atlas);
+}
+
+atlas_page_t *atlas_page_init(int page_size) {
+  atlas_page_t *page = malloc(sizeof(atlas_page_t));
+  assert(page != NULL);
+  page->surface = SDL_CreateRGBSurfaceWithFormat(0, page_size, page_size, 32,
+                                                 SDL_PIXELFORMAT_RGBA32);
+  assert(page->surface != NULL);
+  page->texture = NULL;
+  page->shelf_x = 0;
+  page->shelf_y = 0;
+  page->shelf_height = 0;
+  return page;
+}
+
+/**
+ * Finds room for a w x h image on a page, opening a new shelf if the open
+ * one is full.
+ * Returns false, leaving the page untouched, if the page has no room.
+ */
+bool atlas_page_place(atlas_page_t *page, int page_size, int w, int h,
+                      SDL_Rect *region) {
+  int x = page->shelf_x, y = page->shelf_y, shelf_height = page->shelf_height;
+  if (x + w > page_size) {
+    x = 0;
+    y += shelf_height + IMAGE_PADDING;
+    shelf_height = 0;
+  }
+  if (x + w > page_size || y + h > page_size) {
+    return false;
+  }
+  *region = (SDL_Rect){x, y, w, h};
+  page->shelf_x = x + w + IMAGE_PADDING;
+  page->shelf_y = y;
+  page->shelf_height = h > shelf_height ? h : shelf_height;
+  return true;
+}
+
+bool sprite_atlas_add(sprite_atlas_t *atlas, SDL_Surface *image, size_t *page,
+                      SDL_Rect *region) {
+  if (image->w > atlas->page_size || image->h > atlas->page_size) {
+    return false;
+  }
+  size_t index;
+  for (index = 0; index < list_size(atlas->pages); index++) {
+    atlas_page_t *candidate = list_get(atlas->pages, index);
+    // Pages that have been uploaded are closed
+    if (candidate->surface != NULL &&
+        atlas_page_place(candidate, atlas->page_size, image->w, image->h,
+                         region)) {
+      break;
+    }
+  }
+  if (index == list_size(atlas->pages)) {
+    atlas_page_t *fresh = atlas_page_init(atlas->page_size);
+    list_add(atlas->pages, fresh);
+    bool placed = atlas_page_place(fresh, atlas->page_size, image->w,
+                                   image->h, region);
+    assert(placed);
+  }
+  atlas_page_t *chosen = list_get(atlas->pages, index);
+  // Copy the image's alpha as is instead of blending it onto the page
+  SDL_SetSurfaceBlendMode(image, SDL_BLENDMODE_NONE);
+  SDL_BlitSurface(image, NULL, chosen->surface, region);
+  *page = index;
+  return true;
+}
+
+void sprite_atlas_upload(sprite_atlas_t *atlas) {
+  for (size_t i = 0; i < list_size(atlas->pages); i++) {
+    atlas_page_t *page = list_get(atlas->pages, i);
+    if (page->surface == NULL) {
+      continue;
+    }
+    page->texture = sdl_create_texture_from_surface(page->surface);
+    SDL_SetTextureBlendMode(page->texture, SDL_BLENDMODE_BLEND);
+    SDL_FreeSurface(page->surface);
+    page->surface = NULL;
+  }
+}
+
+size_t sprite_atlas_pages(sprite_atlas_t *atlas) {
+  return list_size(atlas->pages);
+}
+
+SDL_Texture *sprite_atlas_get_texture(sprite_atlas_t *atlas, size_t page) {
+  atlas_page_t *chosen = list_get(atlas->pages, page);
+  assert(chosen->texture != NULL);
+  return chosen->texture;
+}
+
+int sprite_atlas_page_size(sprite_atlas_t *atlas) { return atlas->page_size; }
@@ -2,6 +2,7 @@
 #include "body.h"
 #include "button.h"
 #include "forces.h"
+#include "game_info.h"
 #include "list.h"
 #include "scene.h"
 #include <stdio.h>
@@ -61,6 +62,7 @@ void state_set_scene(state_t *state, scene_t *scene) { state->scene = scene; }
 list_t *state_get_paddles(state_t *state) { return state->paddles; }
 
 void state_add_paddle(state_t *state, body_t *paddle) {
+  body_set_collision_filter(paddle, PADDLE_CATEGORY, PELLET_CATEGORY);
   scene_add_body(state->scene, paddle);
   list_add(state->paddles, paddle);
 }
@@ -68,6 +70,8 @@ void state_add_paddle(state_t *state, body_t *paddle) {
 list_t *state_get_pellets(state_t *state) { return state->pellets; }
 
 void state_add_pellet(state_t *state, body_t *pellet) {
+  body_set_collision_filter(pellet, PELLET_CATEGORY,
+                            PADDLE_CATEGORY | WALL_CATEGORY);
   scene_add_body(state->scene, pellet);
   list_add(state->pellets, pellet);
 }
@@ -75,6 +79,7 @@ void state_add_pellet(state_t *state, body_t *pellet) {
 list_t *state_get_walls(state_t *state) { return state->walls; }
 
 void state_add_wall(state_t *state, body_t *wall) {
+  body_set_collision_filter(wall, WALL_CATEGORY, PELLET_CATEGORY);
   scene_add_body(state->scene, wall);
   list_add(state->walls, wall);
 }
@@ -87,25 +92,13 @@ void state_add_button(state_t *state, button_t *button) {
 }
 
 void state_create_paddle_pellet_collisions(state_t *state) {
-  for (size_t i = 0; i < list_size(state->paddles); i++) {
-    body_t *curr_paddle = list_get(state->paddles, i);
-    for (size_t j = 0; j < list_size(state->pellets); j++) {
-      body_t *curr_pellet = list_get(state->pellets, j);
-      create_physics_collision(state->scene, PELLET_PADDLE_ELASTICITY,
-                               curr_paddle, curr_pellet);
-    }
-  }
+  scene_add_collision_rule(state->scene, PADDLE_CATEGORY, PELLET_CATEGORY,
+                           PELLET_PADDLE_ELASTICITY);
 }
 
 void state_create_wall_pellet_collisions(state_t *state) {
-  for (size_t i = 0; i < list_size(state->walls); i++) {
-    body_t *curr_wall = list_get(state->walls, i);
-    for (size_t j = 0; j < list_size(state->pellets); j++) {
-      body_t *curr_pellet = list_get(state->pellets, j);
-      create_physics_collision(state->scene, PELLET_WALL_ELASTICITY, curr_wall,
-                               curr_pellet);
-    }
-  }
+  scene_add_collision_rule(state->scene, WALL_CATEGORY, PELLET_CATEGORY,
+                           PELLET_WALL_ELASTICITY);
 }
 
 body_t *state_get_paddle(state_t *state, size_t idx) {
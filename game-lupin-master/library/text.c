@@ -1,24 +1,48 @@
+#include "text.h"
 #include "vector.h"
 #include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-static const SDL_Color WHITE = (SDL_Color){255, 255, 255};
+static const SDL_Color WHITE = (SDL_Color){255, 255, 255, 255};
 
 typedef struct text {
   char *content;
   vector_t pos;
   SDL_Color color;
   int size;
+  bool dynamic;
+  // Rendering of content, or NULL until the text is next drawn
+  SDL_Texture *texture;
+  int width;
+  int height;
 } text_t;
 
+/**
+ * Copies a string into newly allocated memory.
+ */
+char *text_copy_content(const char *content) {
+  char *copy = malloc(strlen(content) + 1);
+  assert(copy != NULL);
+  strcpy(copy, content);
+  return copy;
+}
+
 text_t *text_init_with_color(char *content, vector_t pos, SDL_Color color,
                              int size) {
   text_t *text = malloc(sizeof(text_t));
-  text->content = content;
+  assert(text != NULL);
+  text->content = text_copy_content(content);
   text->pos = pos;
   text->color = color;
   text->size = size;
+  text->dynamic = false;
+  text->texture = NULL;
+  text->width = 0;
+  text->height = 0;
   return text;
 }
 
@@ -26,12 +50,21 @@ text_t *text_init(char *content, vector_t pos, int size) {
   return text_init_with_color(content, pos, WHITE, size);
 }
 
-void text_free(text_t *text) { free(text); }
+void text_free(text_t *text) {
+  text_set_texture(text, NULL, 0, 0);
+  free(text->content);
+  free(text);
+}
 
 char *text_get_content(text_t *text) { return text->content; }
 
 void text_update_content(text_t *text, char *content) {
-  text->content = content;
+  if (strcmp(text->content, content) == 0) {
+    return;
+  }
+  free(text->content);
+  text->content = text_copy_content(content);
+  text_set_texture(text, NULL, 0, 0);
 }
 
 vector_t text_get_pos(text_t *text) { return text->pos; }
@@ -39,3 +72,26 @@ vector_t text_get_pos(text_t *text) { return text->pos; }
 SDL_Color text_get_color(text_t *text) { return text->color; }
 
 int text_get_size(text_t *text) { return text->size; }
+
+bool text_is_dynamic(text_t *text) { return text->dynamic; }
+
+void text_set_dynamic(text_t *text, bool dynamic) {
+  text->dynamic = dynamic;
+  text_set_texture(text, NULL, 0, 0);
+}
+
+SDL_Texture *text_get_texture(text_t *text) { return text->texture; }
+
+int text_get_width(text_t *text) { return text->width; }
+
+int text_get_height(text_t *text) { return text->height; }
+
+void text_set_texture(text_t *text, SDL_Texture *texture, int width,
+                      int height) {
+  if (text->texture != NULL) {
+    SDL_DestroyTexture(text->texture);
+  }
+  text->texture = texture;
+  text->width = width;
+  text->height = height;
+}
@@ -0,0 +1,263 @@
+#include "texture_cache.h"
+#include "list.h"
+#include "mask.h"
+#include "sdl_wrapper.h"
+#include "sprite_atlas.h"
+#include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t INIT_CACHE_SIZE = 16;
+static const size_t TEXTURE_BYTES_PER_PIXEL = 4;
+static const int ATLAS_PAGE_SIZE = 1024;
+
+typedef struct texture_entry {
+  char *path;
+  SDL_Texture *texture;
+  // The part of texture that shows the image
+  SDL_Rect region;
+  // Whether texture is a page of the atlas, shared with other entries.
+  // Packed entries stay cached for good and are not reference counted.
+  bool packed;
+  mask_t *mask;
+  size_t bytes;
+  size_t refs;
+  // Value of use_clock when the entry was last acquired
+  size_t last_use;
+} texture_entry_t;
+
+/**
+ * Every cached texture, referenced or not.
+ */
+static list_t *cache = NULL;
+static sprite_atlas_t *atlas = NULL;
+static size_t cache_bytes = 0;
+static size_t cache_budget = 0;
+static size_t use_clock = 0;
+
+void texture_entry_free(texture_entry_t *entry) {
+  if (!entry->packed) {
+    SDL_DestroyTexture(entry->texture);
+  }
+  if (entry->mask != NULL) {
+    mask_free(entry->mask);
+  }
+  free(entry->path);
+  free(entry);
+}
+
+texture_entry_t *texture_cache_find(const char *path) {
+  if (cache == NULL) {
+    return NULL;
+  }
+  for (size_t i = 0; i < list_size(cache); i++) {
+    texture_entry_t *entry = list_get(cache, i);
+    if (strcmp(entry->path, path) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Removes the cache entry at an index and destroys its texture.
+ */
+void texture_cache_evict(size_t index) {
+  texture_entry_t *entry = list_remove(cache, index);
+  assert(entry->refs == 0);
+  cache_bytes -= entry->bytes;
+  texture_entry_free(entry);
+}
+
+/**
+ * Evicts the least recently used unreferenced textures
+ * until the cache fits its budget.
+ */
+void texture_cache_trim(void) {
+  while (cache_budget > 0 && cache_bytes > cache_budget) {
+    size_t oldest = list_size(cache);
+    for (size_t i = 0; i < list_size(cache); i++) {
+      texture_entry_t *entry = list_get(cache, i);
+      if (entry->refs == 0 && !entry->packed &&
+          (oldest == list_size(cache) ||
+           entry->last_use <
+               ((texture_entry_t *)list_get(cache, oldest))->last_use)) {
+        oldest = i;
+      }
+    }
+    if (oldest == list_size(cache)) {
+      return; // everything left is in use
+    }
+    texture_cache_evict(oldest);
+  }
+}
+
+/**
+ * Adds an entry for a path to the cache, with no references.
+ */
+texture_entry_t *texture_cache_add(const char *path, SDL_Texture *texture,
+                                   SDL_Rect region, bool packed,
+                                   mask_t *mask) {
+  if (cache == NULL) {
+    cache = list_init(INIT_CACHE_SIZE, (free_func_t)texture_entry_free);
+  }
+  texture_entry_t *entry = malloc(sizeof(texture_entry_t));
+  assert(entry != NULL);
+  entry->path = malloc(strlen(path) + 1);
+  assert(entry->path != NULL);
+  strcpy(entry->path, path);
+  entry->texture = texture;
+  entry->region = region;
+  entry->packed = packed;
+  entry->mask = mask;
+  // Atlas pages are counted once, when they are packed
+  entry->bytes =
+      packed ? 0 : (size_t)region.w * region.h * TEXTURE_BYTES_PER_PIXEL;
+  entry->refs = 0;
+  entry->last_use = use_clock;
+  list_add(cache, entry);
+  cache_bytes += entry->bytes;
+  return entry;
+}
+
+/**
+ * Finds or loads the cache entry for a path and takes a reference to it.
+ * If with_mask is true, the entry's mask is built if it is missing.
+ */
+texture_entry_t *texture_cache_get(const char *path, bool with_mask) {
+  texture_entry_t *entry = texture_cache_find(path);
+  if (entry == NULL) {
+    mask_t *mask = NULL;
+    SDL_Texture *texture = with_mask
+                               ? sdl_create_texture_with_mask(path, &mask)
+                               : sdl_create_texture(path);
+    int w, h;
+    SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+    entry = texture_cache_add(path, texture, (SDL_Rect){0, 0, w, h}, false,
+                              mask);
+  } else if (with_mask && entry->mask == NULL) {
+    entry->mask = sdl_create_mask(path);
+  }
+  if (!entry->packed) {
+    entry->refs++;
+  }
+  entry->last_use = ++use_clock;
+  texture_cache_trim();
+  return entry;
+}
+
+SDL_Texture *texture_cache_acquire(const char *path, SDL_Rect *region) {
+  texture_entry_t *entry = texture_cache_get(path, false);
+  if (region != NULL) {
+    *region = entry->region;
+  }
+  return entry->texture;
+}
+
+SDL_Texture *texture_cache_acquire_with_mask(const char *path, mask_t **mask,
+                                             SDL_Rect *region) {
+  texture_entry_t *entry = texture_cache_get(path, true);
+  *mask = entry->mask;
+  if (region != NULL) {
+    *region = entry->region;
+  }
+  return entry->texture;
+}
+
+typedef struct pack_image {
+  const char *path;
+  SDL_Surface *surface;
+} pack_image_t;
+
+int pack_image_compare(const void *a, const void *b) {
+  const pack_image_t *image1 = a, *image2 = b;
+  return image2->surface->h - image1->surface->h;
+}
+
+void texture_cache_pack(const char **paths, size_t count) {
+  assert(atlas == NULL);
+  atlas = sprite_atlas_init(ATLAS_PAGE_SIZE);
+  pack_image_t *images = malloc(sizeof(pack_image_t) * count);
+  assert(images != NULL);
+  size_t loaded = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (texture_cache_find(paths[i]) == NULL) {
+      images[loaded].path = paths[i];
+      images[loaded].surface = sdl_load_rgba_surface(paths[i]);
+      loaded++;
+    }
+  }
+  // Shelves waste the least space when images are added tallest first
+  qsort(images, loaded, sizeof(pack_image_t), pack_image_compare);
+
+  size_t *pages = malloc(sizeof(size_t) * loaded);
+  assert(pages != NULL);
+  SDL_Rect *regions = malloc(sizeof(SDL_Rect) * loaded);
+  assert(regions != NULL);
+  bool *packed = malloc(sizeof(bool) * loaded);
+  assert(packed != NULL);
+  for (size_t i = 0; i < loaded; i++) {
+    packed[i] =
+        sprite_atlas_add(atlas, images[i].surface, &pages[i], &regions[i]);
+    SDL_FreeSurface(images[i].surface);
+  }
+  sprite_atlas_upload(atlas);
+  for (size_t i = 0; i < loaded; i++) {
+    // Images too large for a page are loaded on their own when acquired
+    if (packed[i]) {
+      texture_cache_add(images[i].path,
+                        sprite_atlas_get_texture(atlas, pages[i]), regions[i],
+                        true, NULL);
+    }
+  }
+  cache_bytes += sprite_atlas_pages(atlas) * ATLAS_PAGE_SIZE *
+                 ATLAS_PAGE_SIZE * TEXTURE_BYTES_PER_PIXEL;
+  free(images);
+  free(pages);
+  free(regions);
+  free(packed);
+}
+
+bool texture_cache_release(SDL_Texture *texture) {
+  if (cache == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < list_size(cache); i++) {
+    texture_entry_t *entry = list_get(cache, i);
+    if (entry->texture == texture) {
+      if (entry->packed) {
+        return true;
+      }
+      assert(entry->refs > 0);
+      entry->refs--;
+      if (entry->refs == 0) {
+        texture_cache_trim();
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void texture_cache_set_budget(size_t bytes) {
+  cache_budget = bytes;
+  if (cache != NULL) {
+    texture_cache_trim();
+  }
+}
+
+size_t texture_cache_get_bytes(void) { return cache_bytes; }
+
+void texture_cache_purge(void) {
+  if (cache == NULL) {
+    return;
+  }
+  for (size_t i = list_size(cache); i > 0; i--) {
+    texture_entry_t *entry = list_get(cache, i - 1);
+    if (entry->refs == 0 && !entry->packed) {
+      texture_cache_evict(i - 1);
+    }
+  }
+}
@@ -0,0 +1,394 @@
+#include "toi.h"
+#include "body.h"
+#include "broadphase.h"
+#include "list.h"
+#include "polygon.h"
+#include "vector.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const size_t INIT_HEAP_CAPACITY = 64;
+static const size_t INIT_RECORDS_CAPACITY = 16;
+// Beyond this many impacts in one call, the bodies are likely pinched
+static const size_t MAX_IMPACTS_PER_ADVANCE = 1024;
+
+typedef struct impact {
+  double time;
+  body_t *body1;
+  body_t *body2;
+  size_t version1;
+  size_t version2;
+  vector_t axis;
+  // Whether the boxes stop overlapping here rather than start; only
+  // predicted for sensor pairs, which report both
+  bool separating;
+} impact_t;
+
+/** What the queue last knew about a body, in the order of the scene */
+typedef struct record {
+  body_t *body;
+  size_t version;
+  bool changed;
+} record_t;
+
+typedef struct toi {
+  impact_t *heap;
+  size_t size;
+  size_t capacity;
+  record_t *records;
+  size_t record_count;
+  size_t record_capacity;
+  // scene time the predictions are measured from
+  double clock;
+  bool valid;
+  size_t last_impacts;
+} toi_t;
+
+toi_t *toi_init(void) {
+  toi_t *toi = malloc(sizeof(toi_t));
+  assert(toi != NULL);
+  toi->capacity = INIT_HEAP_CAPACITY;
+  toi->heap = malloc(sizeof(impact_t) * toi->capacity);
+  assert(toi->heap != NULL);
+  toi->size = 0;
+  toi->record_capacity = INIT_RECORDS_CAPACITY;
+  toi->records = malloc(sizeof(record_t) * toi->record_capacity);
+  assert(toi->records != NULL);
+  toi->record_count = 0;
+  toi->clock = 0;
+  toi->valid = false;
+  toi->last_impacts = 0;
+  return toi;
+}
+
+void toi_free(toi_t *toi) {
+  free(toi->heap);
+  free(toi->records);
+  free(toi);
+}
+
+void toi_invalidate(toi_t *toi) {
+  toi->valid = false;
+  toi->size = 0;
+}
+
+void toi_swap(toi_t *toi, size_t i, size_t j) {
+  impact_t temp = toi->heap[i];
+  toi->heap[i] = toi->heap[j];
+  toi->heap[j] = temp;
+}
+
+void toi_sift_up(toi_t *toi, size_t index) {
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (toi->heap[parent].time <= toi->heap[index].time) {
+      return;
+    }
+    toi_swap(toi, parent, index);
+    index = parent;
+  }
+}
+
+void toi_sift_down(toi_t *toi, size_t index) {
+  while (true) {
+    size_t smallest = index;
+    size_t left = 2 * index + 1;
+    size_t right = left + 1;
+    if (left < toi->size && toi->heap[left].time < toi->heap[smallest].time) {
+      smallest = left;
+    }
+    if (right < toi->size &&
+        toi->heap[right].time < toi->heap[smallest].time) {
+      smallest = right;
+    }
+    if (smallest == index) {
+      return;
+    }
+    toi_swap(toi, smallest, index);
+    index = smallest;
+  }
+}
+
+void toi_pop(toi_t *toi) {
+  toi->size--;
+  toi->heap[0] = toi->heap[toi->size];
+  toi_sift_down(toi, 0);
+}
+
+bool toi_is_current(impact_t *impact) {
+  return impact->version1 == body_get_version(impact->body1) &&
+         impact->version2 == body_get_version(impact->body2) &&
+         !body_is_removed(impact->body1) && !body_is_removed(impact->body2);
+}
+
+/** Keeps only the impacts that pass the filter, then restores the heap */
+void toi_filter(toi_t *toi, body_t *removed) {
+  size_t kept = 0;
+  for (size_t i = 0; i < toi->size; i++) {
+    impact_t *impact = &toi->heap[i];
+    bool keep = removed == NULL ? toi_is_current(impact)
+                                : impact->body1 != removed &&
+                                      impact->body2 != removed;
+    if (keep) {
+      toi->heap[kept++] = *impact;
+    }
+  }
+  toi->size = kept;
+  for (size_t i = toi->size / 2; i-- > 0;) {
+    toi_sift_down(toi, i);
+  }
+}
+
+void toi_push(toi_t *toi, impact_t impact) {
+  if (toi->size == toi->capacity) {
+    // drop stale predictions before growing
+    toi_filter(toi, NULL);
+  }
+  if (toi->size == toi->capacity) {
+    toi->capacity *= 2;
+    toi->heap = realloc(toi->heap, sizeof(impact_t) * toi->capacity);
+    assert(toi->heap != NULL);
+  }
+  toi->heap[toi->size] = impact;
+  toi_sift_up(toi, toi->size);
+  toi->size++;
+}
+
+void toi_remove_body(toi_t *toi, body_t *body) { toi_filter(toi, body); }
+
+/**
+ * Finds when two boxes moving at constant velocities start to overlap.
+ * Returns false if they already overlap or never will. Otherwise sets the
+ * time from now and the axis the boxes meet along, from box1 towards box2,
+ * and the time from now when they stop overlapping again.
+ */
+bool toi_sweep(aabb_t box1, vector_t vel1, aabb_t box2, vector_t vel2,
+               double *time, vector_t *axis, double *exit_time) {
+  vector_t vel = vec_subtract(vel2, vel1);
+  double min1[] = {box1.min.x, box1.min.y};
+  double max1[] = {box1.max.x, box1.max.y};
+  double min2[] = {box2.min.x, box2.min.y};
+  double max2[] = {box2.max.x, box2.max.y};
+  double speed[] = {vel.x, vel.y};
+  double entry = -INFINITY;
+  double exit = INFINITY;
+  size_t entry_axis = 0;
+  double entry_sign = 0;
+  for (size_t k = 0; k < 2; k++) {
+    double enter;
+    double leave;
+    double sign = 0;
+    if (max2[k] < min1[k]) {
+      // box2 is below box1 along this axis and has to move up
+      if (speed[k] <= 0) {
+        return false;
+      }
+      enter = (min1[k] - max2[k]) / speed[k];
+      leave = (max1[k] - min2[k]) / speed[k];
+      sign = -1;
+    } else if (min2[k] > max1[k]) {
+      if (speed[k] >= 0) {
+        return false;
+      }
+      enter = (min2[k] - max1[k]) / -speed[k];
+      leave = (max2[k] - min1[k]) / -speed[k];
+      sign = 1;
+    } else {
+      enter = -INFINITY;
+      leave = speed[k] > 0   ? (max1[k] - min2[k]) / speed[k]
+              : speed[k] < 0 ? (max2[k] - min1[k]) / -speed[k]
+                             : INFINITY;
+    }
+    if (enter > entry) {
+      entry = enter;
+      entry_axis = k;
+      entry_sign = sign;
+    }
+    exit = fmin(exit, leave);
+  }
+  if (entry == -INFINITY || entry > exit) {
+    return false;
+  }
+  *time = entry;
+  *exit_time = exit;
+  *axis = entry_axis == 0 ? (vector_t){entry_sign, 0}
+                          : (vector_t){0, entry_sign};
+  return true;
+}
+
+/**
+ * Finds when two overlapping boxes moving at constant velocities separate.
+ * Returns false if they never do.
+ */
+bool toi_exit(aabb_t box1, vector_t vel1, aabb_t box2, vector_t vel2,
+              double *time) {
+  vector_t vel = vec_subtract(vel2, vel1);
+  double exit = INFINITY;
+  if (vel.x > 0) {
+    exit = fmin(exit, (box1.max.x - box2.min.x) / vel.x);
+  } else if (vel.x < 0) {
+    exit = fmin(exit, (box2.max.x - box1.min.x) / -vel.x);
+  }
+  if (vel.y > 0) {
+    exit = fmin(exit, (box1.max.y - box2.min.y) / vel.y);
+  } else if (vel.y < 0) {
+    exit = fmin(exit, (box2.max.y - box1.min.y) / -vel.y);
+  }
+  *time = fmax(exit, 0);
+  return exit != INFINITY;
+}
+
+void toi_predict(toi_t *toi, broadphase_t *bp, body_t *body1, body_t *body2,
+                 double now) {
+  vector_t vel1 = body_get_velocity(body1);
+  vector_t vel2 = body_get_velocity(body2);
+  if (vel1.x == vel2.x && vel1.y == vel2.y) {
+    return;
+  }
+  if (body_is_removed(body1) || body_is_removed(body2) ||
+      !broadphase_interacts(bp, body1, body2)) {
+    return;
+  }
+  impact_t impact = {.body1 = body1,
+                     .body2 = body2,
+                     .version1 = body_get_version(body1),
+                     .version2 = body_get_version(body2),
+                     .separating = false};
+  aabb_t box1 = body_get_bounds(body1);
+  aabb_t box2 = body_get_bounds(body2);
+  bool sensor = body_is_sensor(body1) || body_is_sensor(body2);
+  double time;
+  double exit_time;
+  if (toi_sweep(box1, vel1, box2, vel2, &time, &impact.axis, &exit_time)) {
+    // a sensor pair that only grazes would begin and end at once
+    if (sensor && exit_time <= time) {
+      return;
+    }
+    impact.time = now + time;
+    toi_push(toi, impact);
+  } else if (!sensor || !aabb_overlap(box1, box2)) {
+    return;
+  } else {
+    // the sensor pair already overlaps (it may have just begun, or its
+    // motion changed since); make sure it has begun, and predict its end
+    bool ends = toi_exit(box1, vel1, box2, vel2, &exit_time);
+    if (ends && exit_time == 0) {
+      return; // the boxes only touch and are moving apart
+    }
+    broadphase_impact(bp, body1, body2, VEC_ZERO);
+    if (!ends) {
+      return;
+    }
+  }
+  if (sensor) {
+    impact.time = now + exit_time;
+    impact.separating = true;
+    toi_push(toi, impact);
+  }
+}
+
+/**
+ * Matches the records to the scene's bodies, marking the ones that moved
+ * differently as changed. Bodies being added or removed start over.
+ */
+void toi_sync(toi_t *toi, list_t *bodies) {
+  size_t size = list_size(bodies);
+  if (size != toi->record_count) {
+    toi_invalidate(toi);
+  }
+  for (size_t i = 0; toi->valid && i < size; i++) {
+    if (toi->records[i].body != list_get(bodies, i)) {
+      toi_invalidate(toi);
+    }
+  }
+  if (size > toi->record_capacity) {
+    while (toi->record_capacity < size) {
+      toi->record_capacity *= 2;
+    }
+    toi->records =
+        realloc(toi->records, sizeof(record_t) * toi->record_capacity);
+    assert(toi->records != NULL);
+  }
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(bodies, i);
+    record_t *record = &toi->records[i];
+    if (!toi->valid || record->version != body_get_version(body)) {
+      record->body = body;
+      record->version = body_get_version(body);
+      record->changed = true;
+    }
+  }
+  toi->record_count = size;
+  toi->valid = true;
+}
+
+/**
+ * Predicts every pair involving a changed body,
+ * once per pair even if both bodies changed.
+ */
+void toi_rescan(toi_t *toi, list_t *bodies, broadphase_t *bp, double now) {
+  toi_sync(toi, bodies);
+  for (size_t i = 0; i < toi->record_count; i++) {
+    if (!toi->records[i].changed) {
+      continue;
+    }
+    for (size_t j = 0; j < toi->record_count; j++) {
+      if (j == i || (toi->records[j].changed && j < i)) {
+        continue;
+      }
+      toi_predict(toi, bp, toi->records[i].body, toi->records[j].body, now);
+    }
+  }
+  for (size_t i = 0; i < toi->record_count; i++) {
+    toi->records[i].changed = false;
+  }
+}
+
+void toi_move_bodies(list_t *bodies, double dt) {
+  if (dt <= 0) {
+    return;
+  }
+  for (size_t i = 0; i < list_size(bodies); i++) {
+    body_t *body = list_get(bodies, i);
+    vector_t vel = body_get_velocity(body);
+    if (!body_is_sleeping(body) && (vel.x != 0 || vel.y != 0)) {
+      body_move_centroid(body, vec_multiply(dt, vel));
+    }
+  }
+}
+
+double toi_advance(toi_t *toi, list_t *bodies, broadphase_t *bp, double dt) {
+  double end = toi->clock + dt;
+  toi_rescan(toi, bodies, bp, toi->clock);
+  toi->last_impacts = 0;
+  while (toi->size > 0) {
+    impact_t impact = toi->heap[0];
+    if (!toi_is_current(&impact)) {
+      toi_pop(toi);
+      continue;
+    }
+    if (impact.time > end) {
+      break;
+    }
+    if (toi->last_impacts == MAX_IMPACTS_PER_ADVANCE) {
+      return end - toi->clock;
+    }
+    toi_pop(toi);
+    toi_move_bodies(bodies, impact.time - toi->clock);
+    toi->clock = fmax(toi->clock, impact.time);
+    if (impact.separating) {
+      broadphase_separate(bp, impact.body1, impact.body2);
+    } else {
+      broadphase_impact(bp, impact.body1, impact.body2, impact.axis);
+    }
+    toi->last_impacts++;
+    toi_rescan(toi, bodies, bp, toi->clock);
+  }
+  toi_move_bodies(bodies, end - toi->clock);
+  toi->clock = end;
+  return 0;
+}
+
+size_t toi_last_impacts(toi_t *toi) { return toi->last_impacts; }
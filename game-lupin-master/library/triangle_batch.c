@@ -0,0 +1,79 @@
+#include "triangle_batch.h"
+#include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdlib.h>
+
+static const size_t INIT_BATCH_VERTICES = 256;
+static const size_t INIT_BATCH_INDICES = 768;
+
+typedef struct triangle_batch {
+  SDL_Vertex *vertices;
+  size_t vertex_count;
+  size_t vertex_capacity;
+  int *indices;
+  size_t index_count;
+  size_t index_capacity;
+} triangle_batch_t;
+
+triangle_batch_t *triangle_batch_init(void) {
+  triangle_batch_t *batch = malloc(sizeof(triangle_batch_t));
+  assert(batch != NULL);
+  batch->vertex_capacity = INIT_BATCH_VERTICES;
+  batch->vertices = malloc(sizeof(SDL_Vertex) * batch->vertex_capacity);
+  assert(batch->vertices != NULL);
+  batch->vertex_count = 0;
+  batch->index_capacity = INIT_BATCH_INDICES;
+  batch->indices = malloc(sizeof(int) * batch->index_capacity);
+  assert(batch->indices != NULL);
+  batch->index_count = 0;
+  return batch;
+}
+
+void triangle_batch_free(triangle_batch_t *batch) {
+  free(batch->vertices);
+  free(batch->indices);
+  free(batch);
+}
+
+SDL_Vertex *triangle_batch_add(triangle_batch_t *batch, size_t vertex_count,
+                               const int *indices, size_t index_count) {
+  if (batch->vertex_count + vertex_count > batch->vertex_capacity) {
+    while (batch->vertex_count + vertex_count > batch->vertex_capacity) {
+      batch->vertex_capacity *= 2;
+    }
+    batch->vertices = realloc(batch->vertices,
+                              sizeof(SDL_Vertex) * batch->vertex_capacity);
+    assert(batch->vertices != NULL);
+  }
+  if (batch->index_count + index_count > batch->index_capacity) {
+    while (batch->index_count + index_count > batch->index_capacity) {
+      batch->index_capacity *= 2;
+    }
+    batch->indices =
+        realloc(batch->indices, sizeof(int) * batch->index_capacity);
+    assert(batch->indices != NULL);
+  }
+  int first = batch->vertex_count;
+  for (size_t i = 0; i < index_count; i++) {
+    batch->indices[batch->index_count + i] = first + indices[i];
+  }
+  batch->index_count += index_count;
+  batch->vertex_count += vertex_count;
+  return batch->vertices + first;
+}
+
+size_t triangle_batch_size(triangle_batch_t *batch) {
+  return batch->index_count / 3;
+}
+
+void triangle_batch_flush(triangle_batch_t *batch, SDL_Renderer *renderer,
+                          SDL_Texture *texture) {
+  if (batch->index_count == 0) {
+    batch->vertex_count = 0;
+    return;
+  }
+  SDL_RenderGeometry(renderer, texture, batch->vertices, batch->vertex_count,
+                     batch->indices, batch->index_count);
+  batch->vertex_count = 0;
+  batch->index_count = 0;
+}
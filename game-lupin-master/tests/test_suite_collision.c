@@ -0,0 +1,146 @@
+#include "collision.h"
+#include "list.h"
+#include "polygon.h"
+#include "shapes.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+// EPA stops within 1e-6 of the boundary, so depths agree to about that
+const double DEPTH_TOLERANCE = 1e-5;
+const double AXIS_TOLERANCE = 1e-5;
+const size_t RANDOM_PAIRS = 2000;
+
+/** Makes a regular polygon with radii rx, ry, rotated and then moved */
+list_t *make_shape(double rx, double ry, size_t vertices, double angle,
+                   vector_t center) {
+  list_t *shape = make_ellipse(rx, ry, vertices);
+  polygon_rotate(shape, angle, VEC_ZERO);
+  polygon_translate(shape, center);
+  return shape;
+}
+
+/** Copies a shape's vertices into a view; the points must be free()d */
+polygon_view_t make_view(list_t *shape) {
+  size_t size = list_size(shape);
+  vector_t *points = malloc(sizeof(vector_t) * size);
+  assert(points != NULL);
+  for (size_t i = 0; i < size; i++) {
+    points[i] = *(vector_t *)list_get(shape, i);
+  }
+  return (polygon_view_t){.points = points, .size = size};
+}
+
+/**
+ * Returns whether a collision's axis points from shape1 towards shape2,
+ * i.e. moving shape2 forwards along it by the depth just separates them.
+ */
+bool isforwards(list_t *shape1, list_t *shape2, collision_info_t info) {
+  vector_t proj1 = shape_projection(&info.axis, shape1);
+  vector_t proj2 = shape_projection(&info.axis, shape2);
+  return within(DEPTH_TOLERANCE, proj1.y - proj2.x, info.depth);
+}
+
+/**
+ * Runs SAT and GJK/EPA on the same pair and checks that they agree on
+ * whether it collides, the axis and the depth.
+ * Returns whether the pair collided.
+ */
+bool check_agreement(list_t *shape1, list_t *shape2) {
+  polygon_view_t view1 = make_view(shape1);
+  polygon_view_t view2 = make_view(shape2);
+  collision_info_t sat = find_collision_sat(view1, view2, NULL);
+  collision_info_t gjk = find_collision_gjk(view1, view2, NULL);
+  free((vector_t *)view1.points);
+  free((vector_t *)view2.points);
+
+  assert(sat.collided == gjk.collided);
+  if (sat.collided) {
+    assert(within(DEPTH_TOLERANCE, sat.depth, gjk.depth));
+    assert(vec_within(AXIS_TOLERANCE, sat.axis, gjk.axis));
+    assert(isclose(vec_dot(gjk.axis, gjk.axis), 1));
+    assert(isforwards(shape1, shape2, sat));
+    assert(isforwards(shape1, shape2, gjk));
+  }
+  return sat.collided;
+}
+
+/** Checks a pair both ways round, then frees it */
+bool check_pair(list_t *shape1, list_t *shape2) {
+  bool collided = check_agreement(shape1, shape2);
+  assert(check_agreement(shape2, shape1) == collided);
+  list_free(shape1);
+  list_free(shape2);
+  return collided;
+}
+
+void test_separated() {
+  list_t *square = make_rect(10, 10);
+  list_t *other = make_rect(10, 10);
+  polygon_translate(other, (vector_t){20, 3});
+  assert(!check_pair(square, other));
+
+  list_t *triangle = make_shape(10, 10, 3, 0.2, (vector_t){0, 0});
+  list_t *circle = make_shape(10, 10, 40, 0, (vector_t){-5, 25});
+  assert(!check_pair(triangle, circle));
+}
+
+void test_shallow_overlap() {
+  list_t *square = make_rect(10, 10);
+  list_t *other = make_rect(10, 10);
+  polygon_translate(other, (vector_t){8, 1});
+  assert(check_pair(square, other));
+
+  list_t *triangle = make_shape(10, 10, 3, 0.3, (vector_t){0, 0});
+  list_t *hexagon = make_shape(6, 6, 6, 0.1, (vector_t){8, -3});
+  assert(check_pair(triangle, hexagon));
+}
+
+void test_contained() {
+  // one shape's projections lie inside the other's on every axis
+  list_t *outer = make_shape(30, 20, 12, 0.4, (vector_t){0, 0});
+  list_t *inner = make_shape(4, 3, 5, 1.1, (vector_t){6, -2});
+  assert(check_pair(outer, inner));
+}
+
+void test_many_vertices() {
+  list_t *circle = make_shape(20, 20, 64, 0.1, (vector_t){0, 0});
+  list_t *ellipse = make_shape(30, 12, 48, 0.7, (vector_t){35, 8});
+  assert(check_pair(circle, ellipse));
+}
+
+void test_random_pairs() {
+  srand(39);
+  size_t collided = 0;
+  for (size_t i = 0; i < RANDOM_PAIRS; i++) {
+    size_t vertices1 = 3 + rand() % 40;
+    size_t vertices2 = 3 + rand() % 40;
+    list_t *shape1 = make_shape(10 + rand() % 30, 10 + rand() % 30, vertices1,
+                                rand() % 628 / 100.0, VEC_ZERO);
+    // keep the centers apart, where the axis from shape1 to shape2 is defined
+    vector_t center = {rand() % 100 - 50 + 0.5, rand() % 100 - 50 + 0.5};
+    list_t *shape2 = make_shape(10 + rand() % 30, 10 + rand() % 30, vertices2,
+                                rand() % 628 / 100.0, center);
+    collided += check_pair(shape1, shape2);
+  }
+  // the sample covers both outcomes
+  assert(collided > 0 && collided < RANDOM_PAIRS);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_separated)
+  DO_TEST(test_shallow_overlap)
+  DO_TEST(test_contained)
+  DO_TEST(test_many_vertices)
+  DO_TEST(test_random_pairs)
+
+  puts("collision_test PASS");
+}